@@ -0,0 +1,121 @@
+#include "BatchRenderer.h"
+#include "SceneFile.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <cstring>
+
+bool BatchRenderer::isRequested(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--render") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BatchRenderer::loadScene(const QString& filePath, SceneSnapshot& snapshot) {
+    if (filePath.endsWith(".vgs")) {
+        snapshot.background.reset();
+        snapshot.layers = QVector<SnapshotLayer>(1);
+        return SceneFile::load(filePath, snapshot.layers[0].shapes, snapshot.size);
+    }
+
+    auto background = QSharedPointer<TiledImage>::create(filePath);
+    if (background->isNull()) {
+        return false;
+    }
+    snapshot.layers.clear();
+    snapshot.background = background;
+    snapshot.size = background->size();
+    return true;
+}
+
+int BatchRenderer::run(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render scene files to images without a window.");
+    parser.addHelpOption();
+    QCommandLineOption renderOption("render", "Run in headless batch mode.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory.", "dir", ".");
+    QCommandLineOption formatOption("format", "Output image format: png or jpg.", "format", "png");
+    QCommandLineOption scaleOption("scale", "Scale factor applied to each scene.", "scale", "1.0");
+    QCommandLineOption threadsOption("threads", "Number of worker threads.", "count",
+        QString::number(QThread::idealThreadCount()));
+    parser.addOption(renderOption);
+    parser.addOption(outputOption);
+    parser.addOption(formatOption);
+    parser.addOption(scaleOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument("files", "Scene files to render.", "files...");
+    parser.process(arguments);
+
+    QTextStream err(stderr);
+    QTextStream out(stdout);
+
+    const QStringList files = parser.positionalArguments();
+    const QString format = parser.value(formatOption).toLower();
+    bool scaleOk = false;
+    const qreal scale = parser.value(scaleOption).toDouble(&scaleOk);
+    const int threads = parser.value(threadsOption).toInt();
+
+    if (files.isEmpty()) {
+        err << "No input files.\n";
+        return 1;
+    }
+    if (format != "png" && format != "jpg") {
+        err << "Unsupported format: " << format << '\n';
+        return 1;
+    }
+    if (!scaleOk || scale <= 0.0) {
+        err << "Invalid scale: " << parser.value(scaleOption) << '\n';
+        return 1;
+    }
+
+    const QDir outputDir(parser.value(outputOption));
+    if (!QDir().mkpath(outputDir.absolutePath())) {
+        err << "Cannot create output directory: " << outputDir.absolutePath() << '\n';
+        return 1;
+    }
+
+    //ÿļһڲ߳Ⱦļ֮䲢
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, threads));
+    QMutex failureMutex;
+    QStringList failures;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString& file : files) {
+        pool.start([&, file]() {
+            SceneSnapshot snapshot;
+            QString error;
+            if (!loadScene(file, snapshot)) {
+                error = "failed to load";
+            }
+            else {
+                QImage image = SceneRenderer::renderImage(snapshot, scale);
+                const QString target = outputDir.filePath(QFileInfo(file).completeBaseName() + "." + format);
+                if (image.isNull() || !image.save(target)) {
+                    error = "failed to save " + target;
+                }
+            }
+            if (!error.isEmpty()) {
+                QMutexLocker locker(&failureMutex);
+                failures.append(file + ": " + error);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    for (const QString& failure : failures) {
+        err << failure << '\n';
+    }
+    out << "Rendered " << (files.size() - failures.size()) << "/" << files.size()
+        << " files in " << timer.elapsed() << " ms\n";
+    return failures.isEmpty() ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QStringList>
+#include "SceneRenderer.h"
+
+//޽Ⱦ QWidget offscreen ƽ̨
+//÷VectorGraphicsRenderingSystem --render -o <Ŀ¼> [--format png|jpg] [--scale ] ļ...
+class BatchRenderer {
+public:
+    //ǷȾڴӦö֮ǰжϣ
+    static bool isRequested(int argc, char* argv[]);
+
+    //̳߳вȾȫļȫɹʱ 0
+    static int run(const QStringList& arguments);
+
+    //ȡļ.vgs ʸ PNG/JPG Ϊ
+    static bool loadScene(const QString& filePath, SceneSnapshot& snapshot);
+};
+
+#endif // BATCHRENDERER_H
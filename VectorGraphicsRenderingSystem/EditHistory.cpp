@@ -0,0 +1,103 @@
+#include "EditHistory.h"
+#include <utility>
+
+EditHistory::EditHistory(qint64 memoryLimit)
+    : limit(memoryLimit), usage(0) {
+}
+
+void EditHistory::setMemoryLimit(qint64 bytes) {
+    limit = bytes;
+    trim();
+}
+
+//һ¼ռõڴ
+qint64 EditHistory::cost(const Edit& edit) {
+    qint64 bytes = sizeof(Edit) + qint64(edit.points.size()) * sizeof(QPoint)
+        + qint64(edit.ids.size() + edit.oldStyles.size() + edit.positions.size()) * sizeof(int);
+    if (edit.scene) {
+        bytes += edit.scene->byteSize();
+    }
+    return bytes;
+}
+
+void EditHistory::record(Edit edit) {
+    for (const Edit& undone : redoStack) {
+        usage -= cost(undone);
+    }
+    redoStack.clear();
+
+    //ƽͬһͼΣͬһͼΣʱֻۼƽ
+    if ((edit.kind == Edit::MoveShape || edit.kind == Edit::MoveShapes) && !undoStack.empty()) {
+        Edit& last = undoStack.back();
+        if (last.kind == edit.kind && last.id == edit.id && last.ids == edit.ids) {
+            last.offset += edit.offset;
+            if (last.offset.isNull()) {
+                usage -= cost(last);
+                undoStack.pop_back();
+            }
+            return;
+        }
+    }
+    //ʽĸκϲʱƳ
+    if (edit.kind == Edit::AppendShapes && !undoStack.empty() && undoStack.back().kind == Edit::AppendShapes) {
+        Edit& last = undoStack.back();
+        last.ids += edit.ids;
+        usage += qint64(edit.ids.size()) * sizeof(int);
+        trim();
+        return;
+    }
+
+    usage += cost(edit);
+    undoStack.push_back(std::move(edit));
+    trim();
+}
+
+void EditHistory::clear() {
+    undoStack.clear();
+    redoStack.clear();
+    usage = 0;
+}
+
+bool EditHistory::takeUndo(Edit& edit) {
+    if (undoStack.empty()) {
+        return false;
+    }
+    edit = std::move(undoStack.back());
+    undoStack.pop_back();
+    usage -= cost(edit);
+    return true;
+}
+
+bool EditHistory::takeRedo(Edit& edit) {
+    if (redoStack.empty()) {
+        return false;
+    }
+    edit = std::move(redoStack.back());
+    redoStack.pop_back();
+    usage -= cost(edit);
+    return true;
+}
+
+void EditHistory::pushUndo(Edit edit) {
+    usage += cost(edit);
+    undoStack.push_back(std::move(edit));
+    trim();
+}
+
+void EditHistory::pushRedo(Edit edit) {
+    usage += cost(edit);
+    redoStack.push_back(std::move(edit));
+    trim();
+}
+
+//ʱȶĳ¼ȻٶŻļ¼
+void EditHistory::trim() {
+    while (usage > limit && !undoStack.empty()) {
+        usage -= cost(undoStack.front());
+        undoStack.pop_front();
+    }
+    while (usage > limit && !redoStack.empty()) {
+        usage -= cost(redoStack.front());
+        redoStack.pop_front();
+    }
+}
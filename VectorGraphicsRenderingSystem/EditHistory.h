@@ -0,0 +1,77 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <QVector>
+#include <QPoint>
+#include <QColor>
+#include <QSharedPointer>
+#include <deque>
+#include "ShapeStore.h"
+
+///¼ÿα༭ֻ¼ͼIDƽ¾ʽ±ȣ
+//ϸ񰴺ȳ˳ִУ˸¼Զ򡢷Ӧ
+//ռóʱļ¼ƽͬһͼΣͬһͼΣϲΪһ׷ӵҲϲΪһ
+class EditHistory {
+public:
+    struct Edit {
+        enum Kind : quint8 {
+            AddShape,
+            MoveShape,
+            RecolorShape,
+            ClearShapes,
+            MoveShapes,
+            RecolorShapes,
+            RemoveShapes,
+            AppendShapes
+        };
+
+        Kind kind = AddShape;
+        int id = -1;
+        QPoint offset;
+        int oldStyle = -1;
+        int newStyle = -1;
+
+        //༭еͼIDɫʱԭʽ±ꣻ׷ʱΪ׷ӵͼ
+        QVector<int> ids;
+        QVector<int> oldStyles;
+
+        //ͼα󱣴伸ɫʱ
+        ShapeStore::ShapeType type = ShapeStore::NoneType;
+        QColor color;
+        QVector<QPoint> points;
+
+        //ʱƳͼβֿ⣻ɾʱΪɾͼɵĲֿ⣬positions Ϊԭ±꣨
+        QSharedPointer<ShapeStore> scene;
+        QVector<int> positions;
+    };
+
+    explicit EditHistory(qint64 memoryLimit = 64 * 1024 * 1024);
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const { return limit; }
+    qint64 memoryUsage() const { return usage; }
+
+    //¼µı༭ջ
+    void record(Edit edit);
+    void clear();
+
+    bool canUndo() const { return !undoStack.empty(); }
+    bool canRedo() const { return !redoStack.empty(); }
+
+    //ȡջ¼ɵ÷ӦúٷŻһջ
+    bool takeUndo(Edit& edit);
+    bool takeRedo(Edit& edit);
+    void pushUndo(Edit edit);
+    void pushRedo(Edit edit);
+
+private:
+    static qint64 cost(const Edit& edit);
+    void trim();
+
+    std::deque<Edit> undoStack;
+    std::deque<Edit> redoStack;
+    qint64 limit;
+    qint64 usage;
+};
+
+#endif // EDITHISTORY_H
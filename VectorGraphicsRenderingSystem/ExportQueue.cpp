@@ -0,0 +1,81 @@
+#include "ExportQueue.h"
+#include "SceneExporter.h"
+#include "PngEncoder.h"
+#include "VectorExporter.h"
+#include "Profiler.h"
+#include <QElapsedTimer>
+
+void ExportWorker::run(const SceneSnapshot& snapshot, qreal scale, const QString& filePath) {
+    PROFILE_SCOPE("ExportWorker::run");
+    QElapsedTimer timer;
+    timer.start();
+
+    //ֻڰٷֱȱ仯ʱ
+    int reported = -1;
+    auto report = [this, &filePath, &reported](int percent) {
+        if (percent != reported) {
+            reported = percent;
+            emit progress(filePath, percent);
+        }
+    };
+    report(0);
+
+    //ʸʽֱдͼΣդԵ
+    const bool svg = filePath.endsWith(".svg", Qt::CaseInsensitive);
+    if (svg || filePath.endsWith(".pdf", Qt::CaseInsensitive)) {
+        auto vectorProgress = [&report](int done, int total) {
+            report(total > 0 ? done * 100 / total : 0);
+        };
+        const bool ok = svg ? VectorExporter::saveSvg(snapshot, filePath, vectorProgress)
+            : VectorExporter::savePdf(snapshot, filePath, vectorProgress);
+        report(100);
+        emit finished(filePath, ok, timer.elapsed());
+        return;
+    }
+
+    SceneExporter exporter;
+    const QImage image = exporter.render(snapshot, scale, [&report](int done, int total) {
+        report(total > 0 ? done * 50 / total : 0);
+    });
+    bool ok = !image.isNull();
+    if (ok) {
+        report(50);
+        if (filePath.endsWith(".png", Qt::CaseInsensitive)) {
+            ok = PngEncoder::save(image, filePath, [&report](int done, int total) {
+                report(50 + (total > 0 ? done * 50 / total : 0));
+            });
+        }
+        else {
+            ok = image.save(filePath);
+        }
+    }
+    report(100);
+    emit finished(filePath, ok, timer.elapsed());
+}
+
+ExportQueue::ExportQueue(QObject* parent)
+    : QObject(parent), worker(new ExportWorker), pendingCount(0) {
+    qRegisterMetaType<SceneSnapshot>("SceneSnapshot");
+
+    worker->moveToThread(&thread);
+    //ͬһ߳Ŷӵĵðύ˳ִУΪ
+    connect(this, &ExportQueue::requested, worker, &ExportWorker::run);
+    connect(worker, &ExportWorker::progress, this, &ExportQueue::progress);
+    connect(worker, &ExportWorker::finished, this, [this](const QString& filePath, bool ok, qint64 elapsedMs) {
+        --pendingCount;
+        emit finished(filePath, ok, elapsedMs);
+    });
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.start();
+}
+
+ExportQueue::~ExportQueue() {
+    //˳ύĵ֮󣬵̴߳ȫ˳
+    QMetaObject::invokeMethod(worker, []() { QThread::currentThread()->quit(); }, Qt::QueuedConnection);
+    thread.wait();
+}
+
+void ExportQueue::enqueue(const SceneSnapshot& snapshot, qreal scale, const QString& filePath) {
+    ++pendingCount;
+    emit requested(snapshot, scale, filePath);
+}
@@ -0,0 +1,49 @@
+#ifndef EXPORTQUEUE_H
+#define EXPORTQUEUE_H
+
+#include <QObject>
+#include <QThread>
+#include <QString>
+#include "SceneRenderer.h"
+
+//ڵ߳Ⱦһ
+class ExportWorker : public QObject {
+    Q_OBJECT
+
+public slots:
+    void run(const SceneSnapshot& snapshot, qreal scale, const QString& filePath);
+
+signals:
+    void progress(const QString& filePath, int percent);
+    void finished(const QString& filePath, bool ok, qint64 elapsedMs);
+};
+
+//̨Уֻ߳գͼβֿʽƣȾڶĵ߳н
+//εύ˳ִУÿڲķֿȾ PNG ʹ̳߳ز
+//Ȱٷֱȱ棬Ⱦռһ
+class ExportQueue : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ExportQueue(QObject* parent = nullptr);
+    //ȴύĵȫ
+    ~ExportQueue();
+
+    void enqueue(const SceneSnapshot& snapshot, qreal scale, const QString& filePath);
+    //ύδɵĵڽеһ
+    int pending() const { return pendingCount; }
+
+signals:
+    void progress(const QString& filePath, int percent);
+    void finished(const QString& filePath, bool ok, qint64 elapsedMs);
+    void requested(const SceneSnapshot& snapshot, qreal scale, const QString& filePath);
+
+private:
+    QThread thread;
+    ExportWorker* worker;
+    int pendingCount;
+};
+
+Q_DECLARE_METATYPE(SceneSnapshot)
+
+#endif // EXPORTQUEUE_H
@@ -0,0 +1,409 @@
+#include "GeometryKernels.h"
+#include <QRectF>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define VGRS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VGRS_AVX2_TARGET
+#else
+#define VGRS_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VGRS_HAVE_SSE2
+#endif
+
+static_assert(sizeof(QPoint) == 2 * sizeof(int), "QPoint must be two ints");
+
+//Ǳʵ֣Ҳڴʵʣβ
+namespace {
+
+void segmentDistancesScalar(const float* x0, const float* y0, const float* x1, const float* y1,
+    int begin, int count, float px, float py, float* out) {
+    for (int i = begin; i < count; ++i) {
+        const float dx = x1[i] - x0[i];
+        const float dy = y1[i] - y0[i];
+        const float wx = px - x0[i];
+        const float wy = py - y0[i];
+        const float lengthSquared = dx * dx + dy * dy;
+        float t = lengthSquared > 0.0f ? (wx * dx + wy * dy) / lengthSquared : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        const float ex = wx - t * dx;
+        const float ey = wy - t * dy;
+        out[i] = ex * ex + ey * ey;
+    }
+}
+
+void ellipsesContainScalar(const float* cx, const float* cy, const float* rx, const float* ry,
+    int begin, int count, float px, float py, float margin, quint8* out) {
+    for (int i = begin; i < count; ++i) {
+        const float nx = (px - cx[i]) / (rx[i] + margin);
+        const float ny = (py - cy[i]) / (ry[i] + margin);
+        out[i] = nx * nx + ny * ny <= 1.0f ? 1 : 0;
+    }
+}
+
+double polylineLengthScalar(const QPoint* points, int begin, int count) {
+    double length = 0.0;
+    for (int i = begin; i + 1 < count; ++i) {
+        const double dx = points[i + 1].x() - points[i].x();
+        const double dy = points[i + 1].y() - points[i].y();
+        length += std::sqrt(dx * dx + dy * dy);
+    }
+    return length;
+}
+
+}
+
+// SSE2 ʵ֣ÿδ 4 Ȼ 2 ˫
+#ifdef VGRS_HAVE_SSE2
+namespace {
+
+void translatePointsSse2(QPoint* points, int count, const QPoint& offset) {
+    // QPoint  xy ڽṹеȺ˳
+    const QPoint pattern[2] = { offset, offset };
+    const __m128i delta = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i* p = reinterpret_cast<__m128i*>(points + i);
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), delta));
+    }
+    for (; i < count; ++i) {
+        points[i] += offset;
+    }
+}
+
+void segmentDistancesSse2(const float* x0, const float* y0, const float* x1, const float* y1,
+    int count, float px, float py, float* out) {
+    const __m128 vpx = _mm_set1_ps(px);
+    const __m128 vpy = _mm_set1_ps(py);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 tiny = _mm_set1_ps(1e-30f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 ax = _mm_loadu_ps(x0 + i);
+        const __m128 ay = _mm_loadu_ps(y0 + i);
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(x1 + i), ax);
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(y1 + i), ay);
+        const __m128 wx = _mm_sub_ps(vpx, ax);
+        const __m128 wy = _mm_sub_ps(vpy, ay);
+        //˻߶εĵΪ 0ԼСֵ t Ϊ 0
+        const __m128 lengthSquared = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), tiny);
+        __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(wx, dx), _mm_mul_ps(wy, dy)), lengthSquared);
+        t = _mm_min_ps(_mm_max_ps(t, zero), one);
+        const __m128 ex = _mm_sub_ps(wx, _mm_mul_ps(t, dx));
+        const __m128 ey = _mm_sub_ps(wy, _mm_mul_ps(t, dy));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+    }
+    segmentDistancesScalar(x0, y0, x1, y1, i, count, px, py, out);
+}
+
+void ellipsesContainSse2(const float* cx, const float* cy, const float* rx, const float* ry,
+    int count, float px, float py, float margin, quint8* out) {
+    const __m128 vpx = _mm_set1_ps(px);
+    const __m128 vpy = _mm_set1_ps(py);
+    const __m128 vmargin = _mm_set1_ps(margin);
+    const __m128 one = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 nx = _mm_div_ps(_mm_sub_ps(vpx, _mm_loadu_ps(cx + i)), _mm_add_ps(_mm_loadu_ps(rx + i), vmargin));
+        const __m128 ny = _mm_div_ps(_mm_sub_ps(vpy, _mm_loadu_ps(cy + i)), _mm_add_ps(_mm_loadu_ps(ry + i), vmargin));
+        const int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one));
+        out[i] = mask & 1;
+        out[i + 1] = (mask >> 1) & 1;
+        out[i + 2] = (mask >> 2) & 1;
+        out[i + 3] = (mask >> 3) & 1;
+    }
+    ellipsesContainScalar(cx, cy, rx, ry, i, count, px, py, margin, out);
+}
+
+//õ 2 ߵ (dx, dy)תΪ˫Ⱥ󳤶
+double polylineLengthSse2(const QPoint* points, int count) {
+    __m128d sum = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 3 <= count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(points + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(points + i + 1));
+        const __m128i d = _mm_sub_epi32(b, a);
+        const __m128d first = _mm_cvtepi32_pd(d);
+        const __m128d second = _mm_cvtepi32_pd(_mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)));
+        //xy Ⱥ˳Ӱƽ
+        const __m128d u = _mm_unpacklo_pd(first, second);
+        const __m128d v = _mm_unpackhi_pd(first, second);
+        sum = _mm_add_pd(sum, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(u, u), _mm_mul_pd(v, v))));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    return lanes[0] + lanes[1] + polylineLengthScalar(points, i, count);
+}
+
+}
+#endif
+
+// AVX2 ʵ֣ÿδ 8 Ȼ 4 ˫ȣֻʱȷ CPU ֺ֧
+#ifdef VGRS_X86
+namespace {
+
+VGRS_AVX2_TARGET
+void translatePointsAvx2(QPoint* points, int count, const QPoint& offset) {
+    const QPoint pattern[4] = { offset, offset, offset, offset };
+    const __m256i delta = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i* p = reinterpret_cast<__m256i*>(points + i);
+        _mm256_storeu_si256(p, _mm256_add_epi32(_mm256_loadu_si256(p), delta));
+    }
+    for (; i < count; ++i) {
+        points[i] += offset;
+    }
+}
+
+VGRS_AVX2_TARGET
+void segmentDistancesAvx2(const float* x0, const float* y0, const float* x1, const float* y1,
+    int count, float px, float py, float* out) {
+    const __m256 vpx = _mm256_set1_ps(px);
+    const __m256 vpy = _mm256_set1_ps(py);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 tiny = _mm256_set1_ps(1e-30f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 ax = _mm256_loadu_ps(x0 + i);
+        const __m256 ay = _mm256_loadu_ps(y0 + i);
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x1 + i), ax);
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y1 + i), ay);
+        const __m256 wx = _mm256_sub_ps(vpx, ax);
+        const __m256 wy = _mm256_sub_ps(vpy, ay);
+        const __m256 lengthSquared = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), tiny);
+        __m256 t = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(wx, dx), _mm256_mul_ps(wy, dy)), lengthSquared);
+        t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+        const __m256 ex = _mm256_sub_ps(wx, _mm256_mul_ps(t, dx));
+        const __m256 ey = _mm256_sub_ps(wy, _mm256_mul_ps(t, dy));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)));
+    }
+    segmentDistancesScalar(x0, y0, x1, y1, i, count, px, py, out);
+}
+
+VGRS_AVX2_TARGET
+void ellipsesContainAvx2(const float* cx, const float* cy, const float* rx, const float* ry,
+    int count, float px, float py, float margin, quint8* out) {
+    const __m256 vpx = _mm256_set1_ps(px);
+    const __m256 vpy = _mm256_set1_ps(py);
+    const __m256 vmargin = _mm256_set1_ps(margin);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 nx = _mm256_div_ps(_mm256_sub_ps(vpx, _mm256_loadu_ps(cx + i)), _mm256_add_ps(_mm256_loadu_ps(rx + i), vmargin));
+        const __m256 ny = _mm256_div_ps(_mm256_sub_ps(vpy, _mm256_loadu_ps(cy + i)), _mm256_add_ps(_mm256_loadu_ps(ry + i), vmargin));
+        const __m256 inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), one, _CMP_LE_OQ);
+        const int mask = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; ++k) {
+            out[i + k] = (mask >> k) & 1;
+        }
+    }
+    ellipsesContainScalar(cx, cy, rx, ry, i, count, px, py, margin, out);
+}
+
+VGRS_AVX2_TARGET
+double polylineLengthAvx2(const QPoint* points, int count) {
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 5 <= count; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + i + 1));
+        const __m256i d = _mm256_sub_epi32(b, a);
+        const __m256d first = _mm256_cvtepi32_pd(_mm256_castsi256_si128(d));
+        const __m256d second = _mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1));
+        //ӵõ 4 ߸Եƽ
+        const __m256d squared = _mm256_hadd_pd(_mm256_mul_pd(first, first), _mm256_mul_pd(second, second));
+        sum = _mm256_add_pd(sum, _mm256_sqrt_pd(squared));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + polylineLengthScalar(points, i, count);
+}
+
+// CPU ϵͳǷ֧ AVX2
+bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+}
+#endif
+
+static GeometryKernels::Isa detect() {
+#ifdef VGRS_X86
+    if (cpuHasAvx2()) {
+        return GeometryKernels::Avx2;
+    }
+#endif
+#ifdef VGRS_HAVE_SSE2
+    return GeometryKernels::Sse2;
+#else
+    return GeometryKernels::Scalar;
+#endif
+}
+
+static std::atomic<int> isaLimit(GeometryKernels::Avx2);
+
+GeometryKernels::Isa GeometryKernels::detectedIsa() {
+    static const Isa detected = detect();
+    return detected;
+}
+
+GeometryKernels::Isa GeometryKernels::isa() {
+    const Isa detected = detectedIsa();
+    const int limit = isaLimit.load(std::memory_order_relaxed);
+    return detected < limit ? detected : Isa(limit);
+}
+
+void GeometryKernels::limitIsa(Isa highest) {
+    isaLimit.store(highest, std::memory_order_relaxed);
+}
+
+const char* GeometryKernels::isaName(Isa isa) {
+    switch (isa) {
+    case Avx2:
+        return "avx2";
+    case Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void GeometryKernels::translatePoints(QPoint* points, int count, const QPoint& offset) {
+    switch (isa()) {
+#ifdef VGRS_X86
+    case Avx2:
+        translatePointsAvx2(points, count, offset);
+        return;
+#endif
+#ifdef VGRS_HAVE_SSE2
+    case Sse2:
+        translatePointsSse2(points, count, offset);
+        return;
+#endif
+    default:
+        for (int i = 0; i < count; ++i) {
+            points[i] += offset;
+        }
+        return;
+    }
+}
+
+void GeometryKernels::segmentDistancesSquared(const float* x0, const float* y0, const float* x1, const float* y1,
+    int count, float px, float py, float* out) {
+    switch (isa()) {
+#ifdef VGRS_X86
+    case Avx2:
+        segmentDistancesAvx2(x0, y0, x1, y1, count, px, py, out);
+        return;
+#endif
+#ifdef VGRS_HAVE_SSE2
+    case Sse2:
+        segmentDistancesSse2(x0, y0, x1, y1, count, px, py, out);
+        return;
+#endif
+    default:
+        segmentDistancesScalar(x0, y0, x1, y1, 0, count, px, py, out);
+        return;
+    }
+}
+
+void GeometryKernels::ellipsesContain(const float* cx, const float* cy, const float* rx, const float* ry,
+    int count, float px, float py, float margin, quint8* out) {
+    switch (isa()) {
+#ifdef VGRS_X86
+    case Avx2:
+        ellipsesContainAvx2(cx, cy, rx, ry, count, px, py, margin, out);
+        return;
+#endif
+#ifdef VGRS_HAVE_SSE2
+    case Sse2:
+        ellipsesContainSse2(cx, cy, rx, ry, count, px, py, margin, out);
+        return;
+#endif
+    default:
+        ellipsesContainScalar(cx, cy, rx, ry, 0, count, px, py, margin, out);
+        return;
+    }
+}
+
+qreal GeometryKernels::polylineLength(const QPoint* points, int count) {
+    switch (isa()) {
+#ifdef VGRS_X86
+    case Avx2:
+        return polylineLengthAvx2(points, count);
+#endif
+#ifdef VGRS_HAVE_SSE2
+    case Sse2:
+        return polylineLengthSse2(points, count);
+#endif
+    default:
+        return polylineLengthScalar(points, 0, count);
+    }
+}
+
+void GeometryKernels::polylineLengths(const QPoint* points, const int* offsets, const int* counts, int count, qreal* out) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = polylineLength(points + offsets[i], counts[i]);
+    }
+}
+
+void SegmentBatch::clear() {
+    x0.clear();
+    y0.clear();
+    x1.clear();
+    y1.clear();
+    indices.clear();
+}
+
+void SegmentBatch::append(int index, const QPoint& a, const QPoint& b, const QPoint& origin) {
+    x0.append(float(a.x() - origin.x()));
+    y0.append(float(a.y() - origin.y()));
+    x1.append(float(b.x() - origin.x()));
+    y1.append(float(b.y() - origin.y()));
+    indices.append(index);
+}
+
+void EllipseBatch::clear() {
+    cx.clear();
+    cy.clear();
+    rx.clear();
+    ry.clear();
+    indices.clear();
+}
+
+void EllipseBatch::append(int index, const QRect& box, const QPoint& origin) {
+    const QRectF r(box);
+    const QPointF center = r.center() - QPointF(origin);
+    cx.append(float(center.x()));
+    cy.append(float(center.y()));
+    rx.append(float(r.width() / 2));
+    ry.append(float(r.height() / 2));
+    indices.append(index);
+}
@@ -0,0 +1,63 @@
+#ifndef GEOMETRYKERNELS_H
+#define GEOMETRYKERNELS_H
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+//ŵں
+//ʱ CPU ֧ѡ AVX2SSE2 ʵ֣ʣ಻һĲ
+class GeometryKernels {
+public:
+    enum Isa {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    //ǰʹõָlimitIsa ɰڸ͵ļ𣬱ڶԱȲ
+    static Isa isa();
+    static Isa detectedIsa();
+    static void limitIsa(Isa highest);
+    static const char* isaName(Isa isa);
+
+    // count ԭƽ offset
+    static void translatePoints(QPoint* points, int count, const QPoint& offset);
+
+    //count ߶ε (px, py) ľƽ˵㰴д
+    static void segmentDistancesSquared(const float* x0, const float* y0, const float* x1, const float* y1,
+        int count, float px, float py, float* out);
+
+    //count ԲԲġᣩǷ (px, py)ȸ marginΪ 0  1
+    static void ellipsesContain(const float* cx, const float* cy, const float* rx, const float* ry,
+        int count, float px, float py, float margin, quint8* out);
+
+    //count ߵĳȣ i Ϊ points[offsets[i]]  counts[i] 
+    static void polylineLengths(const QPoint* points, const int* offsets, const int* counts, int count, qreal* out);
+    static qreal polylineLength(const QPoint* points, int count);
+};
+
+//вԵĺѡ߶Σռ󽻸ںͳһ
+struct SegmentBatch {
+    QVector<float> x0, y0, x1, y1;
+    QVector<int> indices;
+    QVector<float> distances;
+
+    void clear();
+    // origin ΪԭŶ˵㣬Сȵ
+    void append(int index, const QPoint& a, const QPoint& b, const QPoint& origin);
+    int size() const { return indices.size(); }
+};
+
+//вԵĺѡԲ
+struct EllipseBatch {
+    QVector<float> cx, cy, rx, ry;
+    QVector<int> indices;
+    QVector<quint8> inside;
+
+    void clear();
+    void append(int index, const QRect& box, const QPoint& origin);
+    int size() const { return indices.size(); }
+};
+
+#endif // GEOMETRYKERNELS_H
@@ -0,0 +1,48 @@
+#include "ImageLoader.h"
+#include "Profiler.h"
+#include <QElapsedTimer>
+#include <QImageReader>
+
+ImageLoader::ImageLoader(const QString& filePath, QObject* parent)
+    : QObject(parent), filePath(filePath), canceled(false) {
+    qRegisterMetaType<QSharedPointer<TiledImage>>("QSharedPointer<TiledImage>");
+}
+
+void ImageLoader::cancel() {
+    canceled = true;
+}
+
+void ImageLoader::run() {
+    PROFILE_SCOPE("ImageLoader::run");
+    QElapsedTimer timer;
+    timer.start();
+
+    QImageReader reader(filePath);
+    const QSize size = reader.size();
+    if (!size.isValid()) {
+        emit finished(false, QSharedPointer<TiledImage>(), timer.elapsed(), reader.errorString());
+        return;
+    }
+
+    //ְֻ֧ĸʽ۵С룬ʽСͬԤ
+    if (qMax(size.width(), size.height()) > PreviewSize && reader.supportsOption(QImageIOHandler::ClipRect)) {
+        reader.setScaledSize(size.scaled(PreviewSize, PreviewSize, Qt::KeepAspectRatio));
+        const QImage preview = reader.read();
+        if (canceled) {
+            return;
+        }
+        if (!preview.isNull()) {
+            emit previewReady(preview, size);
+        }
+    }
+
+    auto image = QSharedPointer<TiledImage>::create(filePath);
+    if (canceled) {
+        return;
+    }
+    if (image->isNull()) {
+        emit finished(false, QSharedPointer<TiledImage>(), timer.elapsed(), "Failed to decode image.");
+        return;
+    }
+    emit finished(true, image, timer.elapsed(), QString());
+}
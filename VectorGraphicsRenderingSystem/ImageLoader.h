@@ -0,0 +1,39 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSharedPointer>
+#include <QString>
+#include <atomic>
+#include "TiledImage.h"
+
+//̨ͼƬأڹ߳ȶȡļͷСĸʽ JPEGȷһԤ
+//ٹֿ鱳ĸʽڴɽ룩ɺ󽻸߳滻Ԥ
+//ȡֻڸ׶֮Чڽеһνִ꣬
+class ImageLoader : public QObject {
+    Q_OBJECT
+
+public:
+    static const int PreviewSize = 1024;
+
+    explicit ImageLoader(const QString& filePath, QObject* parent = nullptr);
+
+    void cancel();
+
+public slots:
+    void run();
+
+signals:
+    //preview Сʾʱ쵽ԭͼߴ size
+    void previewReady(const QImage& preview, const QSize& size);
+    void finished(bool ok, const QSharedPointer<TiledImage>& image, qint64 elapsedMs, const QString& error);
+
+private:
+    QString filePath;
+    std::atomic<bool> canceled;
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<TiledImage>)
+
+#endif // IMAGELOADER_H
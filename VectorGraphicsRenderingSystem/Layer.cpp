@@ -1,17 +1,35 @@
 #include "Layer.h"
 #include <QPainter>
 #include <QPaintEvent>
+#include <QWheelEvent>
+#include <QKeyEvent>
+#include <QScreen>
 #include <QVBoxLayout>
 #include <QVector2D>
 #include <cmath>
 #include <QInputDialog>
 #include <QColorDialog>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+static const qreal MinZoom = 1.0 / 64;
+static const qreal MaxZoom = 64.0;
+static const qreal HitTolerance = 5.0;//أ㵽в
+static const qreal StrokeTolerance = 1.0;//أֻʼ򻯵ݲ
 
 Layer::Layer(QWidget* parent)
-    : QWidget(parent), drawMode(DrawMode::None), selectedShapeType(ShapeType::NoneType), drawing(false),
-    lineColors({ Qt::black }), polylineColors({ Qt::black }), ellipseColors({ Qt::black }) {
+    : QWidget(parent), drawMode(DrawMode::None), selectedShapeId(-1), drawing(false),
+    currentColor(Qt::black), sceneCacheValid(false), backgroundCacheValid(false), activeLayer(0), zoom(1.0), panning(false),
+    movePending(false), overlayVisible(false), pendingDrawn(0), pendingCulled(0) {
+    layers.emplace_back();
+    layers[0].name = "Layer 1";
     setStyleSheet("border: 1px solid black; background-color: white;");
+    setFocusPolicy(Qt::StrongFocus);
+    moveTimer.setSingleShot(true);
+    connect(&moveTimer, &QTimer::timeout, this, &Layer::flushMove);
     layout = new QVBoxLayout(this);
     layout->setSpacing(0);
     layout->setContentsMargins(0, 0, 0, 0);
@@ -26,7 +44,7 @@ void Layer::addWidget(QWidget* widget) {
     }
 }
 
-//ͼ
+//ջÿͼͼΣͼ㱾
 void Layer::clear() {
     //
     QLayoutItem* item;
@@ -36,183 +54,672 @@ void Layer::clear() {
         }
         delete item;
     }
-    lines.clear();
-    polylines.clear();
-    ellipses.clear();
     currentPolylinePoints.clear();
-    lineLengths.clear();
-    polylineLengths.clear();
-    ellipseAreas.clear();
+    drawing = false;
+    const int active = activeLayer;
+    for (int i = 0; i < layerCount(); ++i) {
+        setCurrentLayer(i);
+        clearShapes();
+    }
+    setCurrentLayer(active);
+    resetView();
+}
+
+//յǰͼ㣬ɳͼβֿͼʷ¼
+void Layer::clearShapes() {
+    if (!shapes.isEmpty()) {
+        EditHistory::Edit edit;
+        edit.kind = EditHistory::Edit::ClearShapes;
+        edit.scene = QSharedPointer<ShapeStore>::create();
+        std::swap(shapes, *edit.scene);
+        history.record(std::move(edit));
+    }
+    shapes.clear();
+    grid.clear();
+    lod.clear();
+    renderList.clear();
+    stats.clear();
+    selectedShapeId = -1;
+    selectedIds.clear();
+    invalidateLayer(activeLayer);
+}
+
+//㵱ǰֻգ߳ʹãֻɼҷǿյͼ
+SceneSnapshot Layer::snapshot() const {
+    SceneSnapshot snapshot{ QVector<SnapshotLayer>(), background, size() };
+    for (int i = 0; i < layerCount(); ++i) {
+        if (layers[i].visible && !shapesOf(i).isEmpty()) {
+            snapshot.layers.append(SnapshotLayer{ shapesOf(i), layers[i].opacity });
+        }
+    }
+    return snapshot;
+}
+
+//׷һͼΣ¼㳤ȡ
+void Layer::appendShapes(const ShapeStore& batch) {
+    //߶ΰߴһں˼㳤
+    batchMetrics.resize(batch.size());
+    GeometryKernels::polylineLengths(batch.pointColumn(), batch.offsetColumn(), batch.countColumn(),
+        batch.size(), batchMetrics.data());
+
+    const int first = shapes.size();
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::AppendShapes;
+    edit.ids.reserve(batch.size());
+    QRect dirty;
+    for (int i = 0; i < batch.size(); ++i) {
+        int id = -1;
+        switch (batch.typeAt(i)) {
+        case ShapeStore::LineType:
+            id = shapes.addLine(batch.lineAt(i), batch.colorAt(i), batchMetrics[i]);
+            break;
+        case ShapeStore::PolylineType: {
+            const PointSpan points = batch.span(i);
+            id = shapes.addPolyline(points.data(), points.size(), batch.colorAt(i), batchMetrics[i]);
+            break;
+        }
+        case ShapeStore::EllipseType:
+            id = shapes.addEllipse(batch.ellipseAt(i), batch.colorAt(i), calculateEllipseArea(batch.ellipseAt(i)));
+            break;
+        case ShapeStore::StrokeType:
+            batch.decodeStroke(i, strokePoints);
+            id = shapes.addStroke(strokePoints.constData(), strokePoints.size(), batch.colorAt(i),
+                calculatePolylineLength(strokePoints.constData(), strokePoints.size()));
+            break;
+        default:
+            break;
+        }
+        if (id >= 0) {
+            const QRect& bounds = shapes.boundsAt(shapes.indexOf(id));
+            grid.insert(id, bounds);
+            renderList.add(shapes, shapes.indexOf(id));
+            stats.add(shapes, shapes.indexOf(id));
+            dirty |= bounds;
+            edit.ids.append(id);
+        }
+    }
+    //¼Ϊɳ׷
+    if (!edit.ids.isEmpty()) {
+        history.record(std::move(edit));
+    }
+
+    //ͼλڵǰͼϲ㣬ֱӵӵͼĻϣºϳӰ
+    SceneLayer& slot = layers[activeLayer];
+    if (slot.cacheValid && !slot.cache.isNull()) {
+        const QRect visible = sceneArea(rect());
+        QVector<int> indices;
+        for (int i = first; i < shapes.size(); ++i) {
+            if (shapes.boundsAt(i).intersects(visible)) {
+                indices.append(i);
+            }
+        }
+        QPainter painter(&slot.cache);
+        painter.setTransform(viewTransform());
+        SceneRenderer::drawShapes(painter, shapes, indices, &lod);
+    }
+    else {
+        slot.cacheValid = false;
+    }
+    const QRect area = widgetArea(dirty) & rect();
+    if (sceneCacheValid && !area.isEmpty()) {
+        composeScene(area);
+    }
+    updateArea(dirty);
+}
+
+//滻ͼ
+void Layer::setShapes(const ShapeStore& store) {
+    shapes = store;
+    grid.build(shapes);
+    lod.clear();
+    renderList.rebuild(shapes);
+    stats.rebuild(shapes);
+    history.clear();
+    selectedShapeId = -1;
+    selectedIds.clear();
+    invalidateLayer(activeLayer);
+}
+
+//ɫѯǰͼĻܣɫδʹʱΪ 0
+SceneStatistics::StyleTotals Layer::layerStatisticsFor(const QColor& color) const {
+    return stats.style(shapes.findStyle(color));
+}
+
+SceneStatistics::StyleTotals Layer::documentTotals() const {
+    SceneStatistics::StyleTotals totals;
+    for (int i = 0; i < layerCount(); ++i) {
+        const SceneStatistics& layerStats = statsOf(i);
+        totals.length += layerStats.totalLength();
+        totals.area += layerStats.totalArea();
+        totals.shapes += layerStats.shapeCount();
+    }
+    return totals;
+}
+
+//ͼĵɫ廥ɫÿͼзֱ
+SceneStatistics::StyleTotals Layer::statisticsFor(const QColor& color) const {
+    SceneStatistics::StyleTotals totals;
+    for (int i = 0; i < layerCount(); ++i) {
+        const SceneStatistics::StyleTotals& layerTotals = statsOf(i).style(shapesOf(i).findStyle(color));
+        totals.length += layerTotals.length;
+        totals.area += layerTotals.area;
+        totals.shapes += layerTotals.shapes;
+    }
+    return totals;
+}
+
+QRect Layer::sceneBounds() const {
+    QRect bounds;
+    for (int i = 0; i < layerCount(); ++i) {
+        bounds |= statsOf(i).bounds();
+    }
+    return bounds;
+}
+
+//ñͼƬ
+void Layer::setBackground(const QSharedPointer<TiledImage>& tiled) {
+    background = tiled;
+    preview = QImage();
+    backgroundCacheValid = false;
+    sceneCacheValid = false;
     update();
 }
 
-//óͼƬ
-void Layer::setImage(const QImage& img) {
-    image = img;
-    update(); 
+void Layer::setPreview(const QImage& image, const QSize& size) {
+    preview = image;
+    previewSize = size;
+    backgroundCacheValid = false;
+    sceneCacheValid = false;
+    update();
+}
+
+//
+int Layer::addLine(const QLine& line, const QColor& color) {
+    int id = shapes.addLine(line, color, calculateLineLength(line));
+    indexShape(id);
+    return id;
+}
+
+//
+int Layer::addPolyline(const QVector<QPoint>& points, const QColor& color) {
+    return addPolyline(points.constData(), points.size(), color);
+}
+
+int Layer::addPolyline(const QPoint* points, int count, const QColor& color) {
+    int id = shapes.addPolyline(points, count, color, calculatePolylineLength(points, count));
+    indexShape(id);
+    return id;
+}
+
+//Բ
+int Layer::addEllipse(const QRect& rect, const QColor& color) {
+    int id = shapes.addEllipse(rect, color, calculateEllipseArea(rect));
+    indexShape(id);
+    return id;
+}
+
+//ӱʼ
+int Layer::addStroke(const QVector<QPoint>& points, const QColor& color) {
+    int id = shapes.addStroke(points.constData(), points.size(), color, calculatePolylineLength(points.constData(), points.size()));
+    indexShape(id);
+    return id;
+}
+
+void Layer::indexShape(int id) {
+    const int index = shapes.indexOf(id);
+    if (index < 0) {
+        return;
+    }
+    grid.insert(id, shapes.boundsAt(index));
+    renderList.add(shapes, index);
+    stats.add(shapes, index);
 }
 
 //ûͼģʽ
 void Layer::setDrawMode(DrawMode mode) {
+    //ʱԤѸύ߻뻺
+    updateArea(previewBounds());
     if (drawMode == Polyline && !currentPolylinePoints.isEmpty()) {
-        polylines.append(QPolygon(currentPolylinePoints));
-        polylineLengths.append(calculatePolylineLength(QPolygon(currentPolylinePoints)));
+        int id = addPolyline(currentPolylinePoints, currentColor);
+        lod.build(shapes, shapes.indexOf(id));
+        recordAdd(id);
+        invalidateScene(shapes.boundsAt(shapes.indexOf(id)));
         currentPolylinePoints.clear();
     }
+    //δɵıʼֱӶ
+    stroke.clear();
     drawMode = mode;
     drawing = false;
-    update();
 }
 
 //滭
 void Layer::paintEvent(QPaintEvent* event) {
-    QPainter painter(this);
-
-    if (!image.isNull()) {
-        painter.drawImage(0, 0, image);
+    PROFILE_SCOPE("Layer::paintEvent");
+    QElapsedTimer frameTimer;
+    if (overlayVisible) {
+        frameTimer.start();
     }
+    QPainter painter(this);
+    const QRect exposed = event->rect();
 
-    // Draw lines with their respective colors
-    for (int i = 0; i < lines.size(); ++i) {
-        if (i < lineColors.size()) {
-            painter.setPen(QPen(lineColors[i], 2));
-        }
-        painter.drawLine(lines[i]);
-    }
+    //ύͼֱӴӻ濽ÿֻ֡Ԥ
+    ensureSceneCache();
+    const qreal dpr = sceneCache.devicePixelRatio();
+    painter.drawImage(QRectF(exposed), sceneCache,
+        QRectF(exposed.x() * dpr, exposed.y() * dpr, exposed.width() * dpr, exposed.height() * dpr));
 
-    // Draw polylines with their respective colors
-    for (int i = 0; i < polylines.size(); ++i) {
-        if (i < polylineColors.size()) {
-            painter.setPen(QPen(polylineColors[i], 2));
+    //ѡͼε
+    if (!selectedIds.isEmpty()) {
+        const QRect frame = selectionBounds();
+        if (!frame.isNull()) {
+            painter.setPen(QPen(Qt::blue, 1, Qt::DashLine));
+            painter.drawRect(viewTransform().mapRect(QRectF(frame.adjusted(-PenWidth, -PenWidth, PenWidth, PenWidth))));
         }
-        painter.drawPolyline(polylines[i]);
     }
 
-    // Draw ellipses with their respective colors
-    for (int i = 0; i < ellipses.size(); ++i) {
-        if (i < ellipseColors.size()) {
-            painter.setPen(QPen(ellipseColors[i], 2));
-        }
-        painter.drawEllipse(ellipses[i]);
+    if (drawing && drawMode == Select) {
+        painter.setTransform(viewTransform());
+        QPen band(Qt::darkGray, 1, Qt::DashLine);
+        band.setCosmetic(true);
+        painter.setPen(band);
+        painter.drawRect(QRect(startPoint, endPoint).normalized());
     }
-
-    if (drawing) {
-        if (drawMode == Line && !startPoint.isNull() && !endPoint.isNull()) {
-            painter.setPen(QPen(lineColors.last(), 2)); // Use last color if drawing a new line
+    else if (drawing) {
+        painter.setTransform(viewTransform());
+        painter.setPen(QPen(currentColor, PenWidth));
+        if (drawMode == Line) {
             painter.drawLine(startPoint, endPoint);
         }
         else if (drawMode == Polyline && !currentPolylinePoints.isEmpty()) {
-            painter.setPen(QPen(polylineColors.last(), 2)); // Use last color if drawing a new polyline
-            for (int i = 0; i < currentPolylinePoints.size() - 1; ++i) {
-                painter.drawLine(currentPolylinePoints[i], currentPolylinePoints[i + 1]);
-            }
+            painter.drawPolyline(currentPolylinePoints.constData(), currentPolylinePoints.size());
             painter.drawLine(currentPolylinePoints.last(), endPoint);
         }
-        else if (drawMode == Ellipse && !startPoint.isNull() && !endPoint.isNull()) {
-            painter.setPen(QPen(ellipseColors.last(), 2)); // Use last color if drawing a new ellipse
+        else if (drawMode == Ellipse) {
             QRect rect(startPoint, endPoint);
             painter.drawEllipse(rect);
         }
+        else if (drawMode == Freehand && !stroke.isEmpty()) {
+            painter.drawPolyline(stroke.points().constData(), stroke.points().size());
+            painter.drawLine(stroke.points().last(), stroke.tail());
+        }
+    }
+
+    //ֻػ㱾֡ͳƣ֡󲹻㣬ʹʾһ֡
+    if (overlayVisible) {
+        const QRect box = overlayRect();
+        const bool overlayOnly = box.contains(exposed);
+        if (!overlayOnly) {
+            frameStats.frameNs = frameTimer.nsecsElapsed();
+            frameStats.drawn = pendingDrawn;
+            frameStats.culled = pendingCulled;
+            pendingDrawn = 0;
+            pendingCulled = 0;
+        }
+        drawOverlay(painter);
+        if (!overlayOnly && !exposed.contains(box)) {
+            update(box);
+        }
+    }
+}
+
+void Layer::setOverlayVisible(bool visible) {
+    if (visible == overlayVisible) {
+        return;
+    }
+    overlayVisible = visible;
+    frameStats = FrameStats();
+    pendingDrawn = 0;
+    pendingCulled = 0;
+    update(overlayRect());
+}
+
+QRect Layer::overlayRect() const {
+    const int lineHeight = fontMetrics().height();
+    return QRect(8, 8, fontMetrics().horizontalAdvance(QString(36, QChar('0'))) + 12, 4 * lineHeight + 8);
+}
+
+static QString hitRate(qint64 hits, qint64 misses) {
+    const qint64 total = hits + misses;
+    return total > 0 ? QString("%1%").arg(100.0 * hits / total, 0, 'f', 1) : QString("-");
+}
+
+void Layer::drawOverlay(QPainter& painter) {
+    QStringList lines;
+    lines << QString("Frame %1 ms").arg(frameStats.frameNs / 1.0e6, 0, 'f', 2);
+    lines << QString("Drawn %1  Culled %2").arg(frameStats.drawn).arg(frameStats.culled);
+    lines << QString("Scene %1  Layers %2")
+        .arg(hitRate(frameStats.sceneHits, frameStats.sceneMisses), hitRate(frameStats.layerHits, frameStats.layerMisses));
+    lines << QString("Tiles %1").arg(background ? hitRate(background->cacheHits(), background->cacheMisses()) : QString("-"));
+
+    const QRect box = overlayRect();
+    painter.save();
+    painter.resetTransform();
+    painter.setOpacity(1.0);
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    const int lineHeight = painter.fontMetrics().height();
+    for (int i = 0; i < lines.size(); ++i) {
+        painter.drawText(QRect(box.x() + 6, box.y() + 4 + i * lineHeight, box.width() - 12, lineHeight),
+            Qt::AlignLeft | Qt::AlignVCenter, lines[i]);
+    }
+    painter.restore();
+}
+
+//ƱԤ
+void Layer::drawBackground(QPainter& painter, const QRect& exposed) {
+    painter.save();
+    painter.setTransform(viewTransform());
+    const QRect area = sceneArea(exposed);
+    if (background) {
+        background->draw(painter, area);
+    }
+    else if (!preview.isNull()) {
+        painter.drawImage(QRect(QPoint(0, 0), previewSize), preview);
+    }
+    painter.restore();
+}
+
+//һͼɼΧཻͼ
+void Layer::drawLayer(QPainter& painter, const QRect& exposed, int index) {
+    SceneLayer& slot = layers[index];
+    const bool active = index == activeLayer;
+    const ShapeStore& layerShapes = active ? shapes : slot.shapes;
+    const SpatialGrid& layerGrid = active ? grid : slot.grid;
+    PolylineLod& layerLod = active ? lod : slot.lod;
+
+    painter.save();
+    painter.setTransform(viewTransform());
+    const QRect area = sceneArea(exposed);
+    //ɼΧǵԪͼʱֱ˳ɨ
+    if (layerGrid.cellCount(area) < layerShapes.size()) {
+        layerGrid.collect(layerShapes, area, shapeCandidates);
+        SceneRenderer::drawShapes(painter, layerShapes, shapeCandidates, &layerLod);
+        pendingDrawn += shapeCandidates.size();
+        pendingCulled += layerShapes.size() - shapeCandidates.size();
     }
+    else {
+        //Χʱͼ㰴ֶύɼΧĲɲü
+        (active ? renderList : slot.renderList).draw(painter, layerShapes, &layerLod);
+        pendingDrawn += layerShapes.size();
+    }
+    painter.restore();
+}
+
+QImage Layer::allocateCache() const {
+    const qreal dpr = devicePixelRatioF();
+    QImage cache(size() * dpr, QImage::Format_ARGB32_Premultiplied);
+    cache.setDevicePixelRatio(dpr);
+    cache.fill(Qt::transparent);
+    return cache;
+}
+
+void Layer::ensureBackgroundCache() {
+    if (backgroundCacheValid) {
+        return;
+    }
+    backgroundCache = QImage();
+    if (background || !preview.isNull()) {
+        backgroundCache = allocateCache();
+        QPainter painter(&backgroundCache);
+        drawBackground(painter, rect());
+    }
+    backgroundCacheValid = true;
+}
+
+void Layer::ensureLayerCache(int index) {
+    SceneLayer& slot = layers[index];
+    if (slot.cacheValid) {
+        ++frameStats.layerHits;
+        return;
+    }
+    ++frameStats.layerMisses;
+    slot.cache = QImage();
+    if (!shapesOf(index).isEmpty()) {
+        slot.cache = allocateCache();
+        QPainter painter(&slot.cache);
+        drawLayer(painter, rect(), index);
+    }
+    slot.cacheValid = true;
+}
+
+//ڳߴͼ仯ȫʧЧ
+void Layer::invalidateCaches() {
+    backgroundCacheValid = false;
+    for (SceneLayer& slot : layers) {
+        slot.cacheValid = false;
+    }
+    sceneCacheValid = false;
+}
+
+//ͼݸı䣬ֻػͼ㣬ͼĻںϳʱ
+void Layer::invalidateLayer(int index) {
+    layers[index].cacheValid = false;
+    sceneCacheValid = false;
+    update();
+}
+
+//ɱɼͼĻºϳɻе exposed 
+void Layer::composeScene(const QRect& exposed) {
+    PROFILE_SCOPE("Layer::composeScene");
+    ensureBackgroundCache();
+    QPainter painter(&sceneCache);
+    painter.setClipRect(exposed);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(exposed, Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    const qreal dpr = sceneCache.devicePixelRatio();
+    const QRectF source(exposed.x() * dpr, exposed.y() * dpr, exposed.width() * dpr, exposed.height() * dpr);
+    if (!backgroundCache.isNull()) {
+        painter.drawImage(QRectF(exposed), backgroundCache, source);
+    }
+    for (int i = 0; i < layerCount(); ++i) {
+        if (!layers[i].visible || layers[i].opacity <= 0.0) {
+            continue;
+        }
+        ensureLayerCache(i);
+        if (!layers[i].cache.isNull()) {
+            painter.setOpacity(layers[i].opacity);
+            painter.drawImage(QRectF(exposed), layers[i].cache, source);
+        }
+    }
+}
+
+//ȷ봰ڳߴ硢豸رһ£ؽ
+void Layer::ensureSceneCache() {
+    const qreal dpr = devicePixelRatioF();
+    if (sceneCache.size() != size() * dpr || sceneCache.devicePixelRatio() != dpr) {
+        invalidateCaches();
+        sceneCache = allocateCache();
+    }
+    if (!sceneCacheValid) {
+        ++frameStats.sceneMisses;
+        composeScene(rect());
+        sceneCacheValid = true;
+    }
+    else {
+        ++frameStats.sceneHits;
+    }
+}
+
+//ǰͼͼα仯ֻػͼ㻺Ӱºϳһ
+void Layer::invalidateScene(const QRect& bounds) {
+    if (bounds.isNull()) {
+        return;
+    }
+    PROFILE_SCOPE("Layer::invalidateScene");
+    const QRect area = widgetArea(bounds) & rect();
+    SceneLayer& slot = layers[activeLayer];
+    if (slot.cacheValid && !area.isEmpty()) {
+        //ͼɿձΪǿգ෴ʱ·䣨ͷţ
+        if (slot.cache.isNull() != shapes.isEmpty()) {
+            slot.cacheValid = false;
+        }
+        else if (!slot.cache.isNull()) {
+            QPainter painter(&slot.cache);
+            painter.setClipRect(area);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.fillRect(area, Qt::transparent);
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+            drawLayer(painter, area, activeLayer);
+        }
+    }
+    if (sceneCacheValid && !area.isEmpty()) {
+        composeScene(area);
+    }
+    updateArea(bounds);
 }
 
 //ƶ
 void Layer::mouseMoveEvent(QMouseEvent* event) {
-    if (drawing && drawMode == Polyline) {
-        endPoint = event->pos();
-        update();
+    if (panning) {
+        pendingPan += event->pos() - panAnchor;
+        panAnchor = event->pos();
+        scheduleMove();
+        return;
+    }
+    //ʼÿֻػ水֡ϲ
+    if (drawing && drawMode == Freehand) {
+        pendingDirty |= stroke.add(mapToScene(event->pos()));
+        scheduleMove();
+        return;
+    }
+    //߶ΡߡԲѡʾƤԤ
+    if (drawing) {
+        pendingMovePos = event->pos();
+        movePending = true;
+        scheduleMove();
+    }
+}
+
+//ʾһ֡ĺȡˢʱ 60 Hz
+int Layer::frameInterval() const {
+    const QScreen* display = screen();
+    const qreal rate = display && display->refreshRate() > 0 ? display->refreshRate() : 60.0;
+    return qMax(1, qRound(1000.0 / rate));
+}
+
+//ϴӦòһ֡ʱȵһ֡дӦõƶʱֻλ
+void Layer::scheduleMove() {
+    if (moveTimer.isActive()) {
+        return;
+    }
+    const qint64 elapsed = lastMoveFrame.isValid() ? lastMoveFrame.elapsed() : frameInterval();
+    moveTimer.start(int(qMax<qint64>(0, frameInterval() - elapsed)));
+}
+
+void Layer::flushMove() {
+    moveTimer.stop();
+    lastMoveFrame.start();
+    if (!pendingPan.isNull()) {
+        const QPoint delta = pendingPan;
+        pendingPan = QPoint();
+        scrollView(delta);
+    }
+    if (!pendingDirty.isNull()) {
+        updateArea(pendingDirty);
+        pendingDirty = QRect();
+    }
+    if (movePending) {
+        movePending = false;
+        if (drawing) {
+            //ֻˢԤľλλ
+            const QRect dirty = previewBounds();
+            endPoint = mapToScene(pendingMovePos);
+            updateArea(dirty | previewBounds());
+        }
     }
 }
 
 //갴ѹ
 void Layer::mousePressEvent(QMouseEvent* event) {
+    flushMove();
+    //м϶ƽƣδѡͼģʽʱҲƽ
+    if (event->button() == Qt::MiddleButton || (drawMode == None && event->button() == Qt::LeftButton)) {
+        panning = true;
+        panAnchor = event->pos();
+        return;
+    }
+    const QPoint pos = mapToScene(event->pos());
+    const qreal tolerance = HitTolerance / zoom;
+
     //ѡģʽ
     if (drawMode == Select) {
-        if (event->button() == Qt::RightButton) {
-            QPoint clickPos = event->pos();
-            const qreal tolerance = 5.0;
+        const bool extend = event->modifiers().testFlag(Qt::ShiftModifier);
+        //϶ѡ
+        if (event->button() == Qt::LeftButton) {
+            startPoint = pos;
+            endPoint = pos;
+            drawing = true;
+        }
+        else if (event->button() == Qt::RightButton) {
+            QPoint clickPos = pos;
 
             ///ѡ״̬
-            selectedShapeType = NoneType;
-            selectedShapeIndex = -1;
-
-            //е
-            for (int i = 0; i < lines.size(); ++i) {
-                if (isPointNearLine(clickPos, lines[i], tolerance)) {
-                    selectedShapeType = LineType;
-                    selectedShapeIndex = i;
-                    showShapeProperties("Line", lineLengths[i]);
-                    return;
-                }
-            }
+            selectedShapeId = -1;
 
-            //е
-            for (int i = 0; i < polylines.size(); ++i) {
-                if (isPointInPolygon(clickPos, polylines[i])) {
-                    selectedShapeType = PolylineType;
-                    selectedShapeIndex = i;
-                    showShapeProperties("Polyline", polylineLengths[i]);
-                    return;
+            int id = hitTest(clickPos, tolerance);
+            if (id >= 0) {
+                int index = shapes.indexOf(id);
+                selectedShapeId = id;
+                //ס Shift ʱлͼεѡ״ֻ̬ѡиͼ
+                if (!extend) {
+                    setSelection(QVector<int>{ id });
                 }
-            }
-
-            //еԲ
-            for (int i = 0; i < ellipses.size(); ++i) {
-                if (ellipses[i].contains(clickPos)) {
-                    selectedShapeType = EllipseType;
-                    selectedShapeIndex = i;
-                    showShapeProperties("Ellipse", ellipseAreas[i]);
-                    return;
+                else if (isSelected(id)) {
+                    QVector<int> ids = selectedIds;
+                    ids.removeOne(id);
+                    setSelection(ids);
                 }
+                else {
+                    setSelection(selectedIds + QVector<int>{ id });
+                }
+                switch (shapes.typeAt(index)) {
+                case ShapeStore::LineType:
+                    showShapeProperties("Line", shapes.metricAt(index));
+                    break;
+                case ShapeStore::PolylineType:
+                    showShapeProperties("Polyline", shapes.metricAt(index));
+                    break;
+                case ShapeStore::EllipseType:
+                    showShapeProperties("Ellipse", shapes.metricAt(index));
+                    break;
+                case ShapeStore::StrokeType:
+                    showShapeProperties("Stroke", shapes.metricAt(index));
+                    break;
+                default:
+                    break;
+                }
+                return;
             }
 
+            if (!extend) {
+                clearSelection();
+            }
             QMessageBox::information(this, "No Shape Selected", "No shape found at the selected position.");
         }
     }
     //ƽģʽ
     else if (drawMode == Move) {
         if (event->button() == Qt::RightButton) {
-            QPoint clickPos = event->pos();
-            const qreal tolerance = 5.0;
-            bool shapeFound = false;
-
-            //е
-            for (int i = 0; i < lines.size(); ++i) {
-                if (isPointNearLine(clickPos, lines[i], tolerance)) {
-                    shapeFound = true;
-                    selectedShapeType = LineType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
-            //е
-            for (int i = 0; i < polylines.size(); ++i) {
-                if (isPointInPolygon(clickPos, polylines[i])) {
-                    shapeFound = true;
-                    selectedShapeType = PolylineType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
-            //еԲ
-            for (int i = 0; i < ellipses.size(); ++i) {
-                if (ellipses[i].contains(clickPos)) {
-                    shapeFound = true;
-                    selectedShapeType = EllipseType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
+            QPoint clickPos = pos;
+
+            int id = hitTest(clickPos, tolerance);
             //ͼαҵתɽ
-            if (shapeFound) {
+            if (id >= 0) {
+                selectedShapeId = id;
+                selectedPoint = clickPos;
                 MoveDialog dialog(this);
                 if (dialog.exec() == QDialog::Accepted) {
                     qreal dx = dialog.getX();
                     qreal dy = dialog.getY();
-                    moveSelectedShape(QPoint(dx, dy));
+                    //еͼڶѡʱƽѡ
+                    if (selectedIds.size() > 1 && isSelected(id)) {
+                        moveShapes(selectedIds, QPoint(dx, dy));
+                    }
+                    else {
+                        moveSelectedShape(QPoint(dx, dy));
+                    }
                 }
             }
             else {
@@ -223,63 +730,42 @@ void Layer::mousePressEvent(QMouseEvent* event) {
     //ɫģʽ
     else if (drawMode == ChangeColor) {
         if (event->button() == Qt::RightButton) {
-            QPoint clickPos = event->pos();
-            const qreal tolerance = 5.0;
-            bool shapeFound = false;
-
-            //е
-            for (int i = 0; i < lines.size(); ++i) {
-                if (isPointNearLine(clickPos, lines[i], tolerance)) {
-                    shapeFound = true;
-                    selectedShapeType = LineType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
-            //е
-            for (int i = 0; i < polylines.size(); ++i) {
-                if (isPointInPolygon(clickPos, polylines[i])) {
-                    shapeFound = true;
-                    selectedShapeType = PolylineType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
-            //еԲ
-            for (int i = 0; i < ellipses.size(); ++i) {
-                if (ellipses[i].contains(clickPos)) {
-                    shapeFound = true;
-                    selectedShapeType = EllipseType;
-                    selectedShapeIndex = i;
-                    selectedPoint = clickPos;
-                    break;
-                }
-            }
+            QPoint clickPos = pos;
+
+            int id = hitTest(clickPos, tolerance);
             //ͼαҵִиɫ
-            if (shapeFound) {
+            if (id >= 0) {
+                selectedShapeId = id;
+                selectedPoint = clickPos;
                 QColor newColor = QColorDialog::getColor(Qt::black, this, "Select Color");
                 if (newColor.isValid()) {
                     changeShapeColor(newColor);
                 }
-                }
             }
+        }
     }
 
     else if (drawMode != None) {
         if (drawMode == Polyline) {
             if (currentPolylinePoints.isEmpty()) {
-                currentPolylinePoints.append(event->pos());
+                currentPolylinePoints.append(pos);
+                endPoint = pos;
                 drawing = true;
             }
             else {
-                currentPolylinePoints.append(event->pos());
-                update();
+                QRect dirty = previewBounds();
+                currentPolylinePoints.append(pos);
+                updateArea(dirty | previewBounds());
+            }
+        }
+        else if (drawMode == Freehand) {
+            if (event->button() == Qt::LeftButton) {
+                stroke.begin(pos, StrokeTolerance / zoom);
+                drawing = true;
             }
         }
         else {
-            startPoint = event->pos();
+            startPoint = pos;
             endPoint = startPoint;
             drawing = true;
         }
@@ -288,29 +774,50 @@ void Layer::mousePressEvent(QMouseEvent* event) {
 
 //ͷ
 void Layer::mouseReleaseEvent(QMouseEvent* event) {
+    flushMove();
+    if (panning) {
+        if (event->button() == Qt::MiddleButton || event->button() == Qt::LeftButton) {
+            panning = false;
+        }
+        return;
+    }
     //޹
     if (drawMode != None && drawMode != Polyline) {
-        endPoint = event->pos();
+        updateArea(previewBounds());
+        endPoint = mapToScene(event->pos());
         //ߵĻյµߣ
         if (drawMode == Line) {
-            lines.append(QLine(startPoint, endPoint));
-            lineLengths.append(calculateLineLength(QLine(startPoint, endPoint)));
+            int id = addLine(QLine(startPoint, endPoint), currentColor);
+            recordAdd(id);
+            invalidateScene(shapes.boundsAt(shapes.indexOf(id)));
         }
         //ԲĻ͸յµԲ
         else if (drawMode == Ellipse) {
-            QRect rect(startPoint, endPoint);
-            ellipses.append(rect);
-            ellipseAreas.append(calculateEllipseArea(rect));
+            int id = addEllipse(QRect(startPoint, endPoint), currentColor);
+            recordAdd(id);
+            invalidateScene(shapes.boundsAt(shapes.indexOf(id)));
+        }
+        else if (drawMode == Select && drawing) {
+            selectArea(QRect(startPoint, endPoint).normalized(), event->modifiers().testFlag(Qt::ShiftModifier));
+        }
+        //ʼɿĲύʼ
+        else if (drawMode == Freehand && drawing) {
+            stroke.add(endPoint);
+            const QVector<QPoint> points = stroke.finish();
+            if (points.size() >= 2) {
+                int id = addStroke(points, currentColor);
+                recordAdd(id);
+                invalidateScene(shapes.boundsAt(shapes.indexOf(id)));
+            }
         }
         drawing = false;
-        update();
     }
 }
 
 //չʾ
 void Layer::showShapeProperties(const QString& shapeType, qreal property) {
     QString propertyString;
-    if (shapeType == "Line" || shapeType == "Polyline") {
+    if (shapeType == "Line" || shapeType == "Polyline" || shapeType == "Stroke") {
         propertyString = QString("Length: %1").arg(property);
     }
     else if (shapeType == "Ellipse") {
@@ -327,9 +834,9 @@ qreal Layer::calculateLineLength(const QLine& line) const {
 }
 
 //߳
-qreal Layer::calculatePolylineLength(const QPolygon& polyline) const {
+qreal Layer::calculatePolylineLength(const QPoint* polyline, int count) const {
     qreal length = 0.0;
-    for (int i = 0; i < polyline.size() - 1; ++i) {
+    for (int i = 0; i < count - 1; ++i) {
         length += QLineF(polyline[i], polyline[i + 1]).length();
     }
     return length;
@@ -343,93 +850,891 @@ qreal Layer::calculateEllipseArea(const QRect& rect) const {
 }
 
 //жϺ
-//жߡߵλùϵ
-bool Layer::isPointNearLine(const QPoint& point, const QLine& line, qreal tolerance) const {
-    QLineF lineF(line);
-    qreal distance = QLineF(lineF.p1(), point).length();
-    if (distance < tolerance) return true;
+//żжϵǷڣպϵģڲ
+bool Layer::isPointInPolygon(const QPoint& point, const PointSpan& polygon) const {
+    const int count = polygon.size();
+    bool inside = false;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        const QPoint& a = polygon[i];
+        const QPoint& b = polygon[j];
+        if ((a.y() > point.y()) != (b.y() > point.y())) {
+            qreal x = a.x() + qreal(point.y() - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+            if (point.x() < x) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+//вԣƵͼ
+int Layer::hitTest(const QPoint& point, qreal tolerance) const {
+    PROFILE_SCOPE("Layer::hitTest");
+    const int reach = int(std::ceil(tolerance));
+    const QRect probe(point.x() - reach, point.y() - reach, 2 * reach + 1, 2 * reach + 1);
+
+    //ɸȡΧཻͼΣ߶Բռɸ
+    grid.collect(shapes, probe, shapeCandidates);
+    hitLines.clear();
+    hitEllipses.clear();
+    for (int index : shapeCandidates) {
+        switch (shapes.typeAt(index)) {
+        case ShapeStore::LineType:
+            hitLines.append(index, shapes.pointsAt(index)[0], shapes.pointsAt(index)[1], point);
+            break;
+        case ShapeStore::EllipseType:
+            hitEllipses.append(index, shapes.boundsAt(index), point);
+            break;
+        case ShapeStore::StrokeType:
+            //ʼβ߶
+            shapes.decodeStroke(index, strokePoints);
+            for (int k = 1; k < strokePoints.size(); ++k) {
+                hitLines.append(index, strokePoints[k - 1], strokePoints[k], point);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    int best = -1;
+    if (hitLines.size() > 0) {
+        hitLines.distances.resize(hitLines.size());
+        GeometryKernels::segmentDistancesSquared(hitLines.x0.constData(), hitLines.y0.constData(),
+            hitLines.x1.constData(), hitLines.y1.constData(), hitLines.size(), 0.0f, 0.0f, hitLines.distances.data());
+        const float limit = float(tolerance * tolerance);
+        for (int k = 0; k < hitLines.size(); ++k) {
+            if (hitLines.distances[k] <= limit) {
+                best = qMax(best, hitLines.indices[k]);
+            }
+        }
+    }
+    if (hitEllipses.size() > 0) {
+        hitEllipses.inside.resize(hitEllipses.size());
+        GeometryKernels::ellipsesContain(hitEllipses.cx.constData(), hitEllipses.cy.constData(),
+            hitEllipses.rx.constData(), hitEllipses.ry.constData(), hitEllipses.size(), 0.0f, 0.0f, float(tolerance),
+            hitEllipses.inside.data());
+        for (int k = 0; k < hitEllipses.size(); ++k) {
+            if (hitEllipses.inside[k]) {
+                best = qMax(best, hitEllipses.indices[k]);
+            }
+        }
+    }
 
-    distance = QLineF(lineF.p2(), point).length();
-    if (distance < tolerance) return true;
+    //жϣֻͼθϵ
+    for (int k = shapeCandidates.size() - 1; k >= 0 && shapeCandidates[k] > best; --k) {
+        const int index = shapeCandidates[k];
+        if (shapes.typeAt(index) == ShapeStore::PolylineType
+            && isPointInPolygon(point, shapes.span(index))) {
+            best = index;
+            break;
+        }
+    }
+    return best >= 0 ? shapes.idAt(best) : -1;
+}
+
+//ǰԤͼεķΧֻƶһ
+QRect Layer::previewBounds() const {
+    if (!drawing) {
+        return QRect();
+    }
+    if (drawMode == Polyline && !currentPolylinePoints.isEmpty()) {
+        return QRect(currentPolylinePoints.last(), endPoint).normalized();
+    }
+    if (drawMode == Line || drawMode == Ellipse || drawMode == Select) {
+        return QRect(startPoint, endPoint).normalized();
+    }
+    if (drawMode == Freehand) {
+        return stroke.bounds();
+    }
+    return QRect();
+}
 
-    qreal numerator = std::abs((lineF.dy() * point.x()) - (lineF.dx() * point.y()) + (lineF.p2().x() * lineF.p1().y()) - (lineF.p2().y() * lineF.p1().x()));
-    qreal denominator = lineF.length();
-    distance = numerator / denominator;
+void Layer::updateArea(const QRect& bounds) {
+    if (!bounds.isNull()) {
+        update(widgetArea(bounds));
+    }
+}
 
-    return (distance <= tolerance && point.x() >= std::min(lineF.p1().x(), lineF.p2().x()) &&
-        point.x() <= std::max(lineF.p1().x(), lineF.p2().x()) &&
-        point.y() >= std::min(lineF.p1().y(), lineF.p2().y()) &&
-        point.y() <= std::max(lineF.p1().y(), lineF.p2().y()));
+//ͼ
+void Layer::swapActiveData(SceneLayer& slot) {
+    std::swap(shapes, slot.shapes);
+    std::swap(grid, slot.grid);
+    std::swap(lod, slot.lod);
+    std::swap(renderList, slot.renderList);
+    std::swap(stats, slot.stats);
+    std::swap(history, slot.history);
 }
 
-bool Layer::isPointInPolygon(const QPoint& point, const QPolygon& polygon) const {
-    return polygon.containsPoint(point, Qt::OddEvenFill);
+const ShapeStore& Layer::shapesOf(int index) const {
+    return index == activeLayer ? shapes : layers[index].shapes;
 }
 
-//ƽ
-void Layer::moveSelectedShape(QPoint translationVector) {
-    //ѡеĲͬͼͣвͬƽ㷨
-    //ֱӶ߶εĶ˵ƽ
-    if (selectedShapeType == LineType && selectedShapeIndex >= 0 && selectedShapeIndex < lines.size()) {
-        QLine newLine(QPoint(lines[selectedShapeIndex].x1() + translationVector.x(), lines[selectedShapeIndex].y1() + translationVector.y()),
-            QPoint(lines[selectedShapeIndex].x2() + translationVector.x(), lines[selectedShapeIndex].y2() + translationVector.y()));
-        lines[selectedShapeIndex] = newLine;
+const SceneStatistics& Layer::statsOf(int index) const {
+    return index == activeLayer ? stats : layers[index].stats;
+}
+
+//лǰͼ㣺ύڻƵߣѡ񲻿ͼ㱣
+void Layer::setCurrentLayer(int index) {
+    if (index < 0 || index >= layerCount() || index == activeLayer) {
+        return;
+    }
+    setDrawMode(drawMode);
+    clearSelection();
+    selectedShapeId = -1;
+    swapActiveData(layers[activeLayer]);
+    activeLayer = index;
+    swapActiveData(layers[activeLayer]);
+    emit layersChanged();
+}
+
+int Layer::addLayer(const QString& name) {
+    const int position = activeLayer + 1;
+    SceneLayer slot;
+    slot.name = name;
+    layers.insert(layers.begin() + position, std::move(slot));
+    setCurrentLayer(position);
+    return position;
+}
+
+void Layer::removeLayer(int index) {
+    if (index < 0 || index >= layerCount() || layerCount() <= 1) {
+        return;
+    }
+    if (index == activeLayer) {
+        setCurrentLayer(index > 0 ? index - 1 : index + 1);
+    }
+    layers.erase(layers.begin() + index);
+    if (activeLayer > index) {
+        --activeLayer;
+    }
+    sceneCacheValid = false;
+    update();
+    emit layersChanged();
+}
+
+//˳ֻºϳɣͼĻ治
+void Layer::moveLayer(int from, int to) {
+    if (from < 0 || from >= layerCount() || to < 0 || to >= layerCount() || from == to) {
+        return;
+    }
+    SceneLayer slot = std::move(layers[from]);
+    layers.erase(layers.begin() + from);
+    layers.insert(layers.begin() + to, std::move(slot));
+    if (activeLayer == from) {
+        activeLayer = to;
+    }
+    else {
+        if (activeLayer > from) {
+            --activeLayer;
+        }
+        if (activeLayer >= to) {
+            ++activeLayer;
+        }
+    }
+    sceneCacheValid = false;
+    update();
+    emit layersChanged();
+}
+
+void Layer::setLayerName(int index, const QString& name) {
+    if (index >= 0 && index < layerCount()) {
+        layers[index].name = name;
+        emit layersChanged();
+    }
+}
+
+void Layer::setLayerVisible(int index, bool visible) {
+    if (index < 0 || index >= layerCount() || layers[index].visible == visible) {
+        return;
+    }
+    layers[index].visible = visible;
+    sceneCacheValid = false;
+    update();
+    emit layersChanged();
+}
+
+void Layer::setLayerOpacity(int index, qreal opacity) {
+    opacity = qBound(0.0, opacity, 1.0);
+    if (index < 0 || index >= layerCount() || layers[index].opacity == opacity) {
+        return;
     }
+    layers[index].opacity = opacity;
+    sceneCacheValid = false;
+    update();
+    emit layersChanged();
+}
 
-    //ߵȫƽ
-    if (selectedShapeType == PolylineType && selectedShapeIndex >= 0 && selectedShapeIndex < polylines.size()) {
-        QPolygon newPolygon = polylines[selectedShapeIndex];
-        for (int j = 0; j < newPolygon.size(); ++j) {
-            newPolygon[j] += translationVector;
+ShapeStore Layer::mergedShapes() const {
+    ShapeStore merged;
+    for (int i = 0; i < layerCount(); ++i) {
+        if (!layers[i].visible) {
+            continue;
         }
-        polylines[selectedShapeIndex] = newPolygon;
+        const ShapeStore& layerShapes = shapesOf(i);
+        for (int k = 0; k < layerShapes.size(); ++k) {
+            switch (layerShapes.typeAt(k)) {
+            case ShapeStore::LineType:
+                merged.addLine(layerShapes.lineAt(k), layerShapes.colorAt(k), layerShapes.metricAt(k));
+                break;
+            case ShapeStore::PolylineType: {
+                const PointSpan points = layerShapes.span(k);
+                merged.addPolyline(points.data(), points.size(), layerShapes.colorAt(k), layerShapes.metricAt(k));
+                break;
+            }
+            case ShapeStore::EllipseType:
+                merged.addEllipse(layerShapes.ellipseAt(k), layerShapes.colorAt(k), layerShapes.metricAt(k));
+                break;
+            case ShapeStore::StrokeType:
+                layerShapes.decodeStroke(k, strokePoints);
+                merged.addStroke(strokePoints.constData(), strokePoints.size(), layerShapes.colorAt(k), layerShapes.metricAt(k));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return merged;
+}
+
+//ͼ任
+QTransform Layer::viewTransform() const {
+    return QTransform(zoom, 0.0, 0.0, zoom, pan.x(), pan.y());
+}
+
+QPoint Layer::mapToScene(const QPoint& widgetPos) const {
+    return ((QPointF(widgetPos) - pan) / zoom).toPoint();
+}
+
+//ӦĳΧʿչ
+QRect Layer::sceneArea(const QRect& widgetArea) const {
+    const QRectF area((QPointF(widgetArea.topLeft()) - pan) / zoom, QSizeF(widgetArea.size()) / zoom);
+    return area.toAlignedRect().adjusted(-PenWidth, -PenWidth, PenWidth, PenWidth);
+}
+
+//Χڴиǵ򣬰ʿչȡ
+QRect Layer::widgetArea(const QRect& sceneBounds) const {
+    const QRect area = sceneBounds.adjusted(-PenWidth, -PenWidth, PenWidth, PenWidth);
+    return viewTransform().mapRect(QRectF(area)).toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+void Layer::resetView() {
+    zoom = 1.0;
+    pan = QPointF();
+    panning = false;
+    invalidateCaches();
+    update();
+}
+
+//ţֹµĳ㲻
+void Layer::wheelEvent(QWheelEvent* event) {
+    const int delta = event->angleDelta().y();
+    if (delta == 0) {
+        event->ignore();
+        return;
+    }
+    zoomAt(event->position(), std::pow(1.25, delta / 120.0));
+    event->accept();
+}
+
+void Layer::zoomAt(const QPointF& anchor, qreal factor) {
+    const qreal newZoom = qBound(MinZoom, zoom * factor, MaxZoom);
+    if (newZoom == zoom) {
+        return;
+    }
+    const QPointF scenePos = (anchor - pan) / zoom;
+    zoom = newZoom;
+    pan = anchor - scenePos * zoom;
+    invalidateCaches();
+    update();
+}
+
+//ƽͼ水豸ƽƺãֻػ¶
+void Layer::scrollView(const QPoint& delta) {
+    if (delta.isNull()) {
+        return;
     }
+    pan += delta;
 
-    //ԲtopLeftƽ
-    if (selectedShapeType == EllipseType && selectedShapeIndex >= 0 && selectedShapeIndex < ellipses.size()) {
-        QRect newRect = ellipses[selectedShapeIndex];
-        newRect.moveTopLeft(newRect.topLeft() + translationVector);
-        ellipses[selectedShapeIndex] = newRect;
+    const qreal dpr = sceneCache.devicePixelRatio();
+    if (!sceneCacheValid || dpr != std::floor(dpr)) {
+        invalidateCaches();
+        update();
+        return;
     }
 
+    const QRegion exposed = QRegion(rect()) - QRegion(rect().translated(delta));
+    if (backgroundCacheValid) {
+        scrollCache(backgroundCache, delta, exposed, [this](QPainter& painter, const QRect& strip) {
+            drawBackground(painter, strip);
+        });
+    }
+    for (int i = 0; i < layerCount(); ++i) {
+        if (layers[i].cacheValid) {
+            scrollCache(layers[i].cache, delta, exposed, [this, i](QPainter& painter, const QRect& strip) {
+                drawLayer(painter, strip, i);
+            });
+        }
+    }
+    scrollCache(sceneCache, delta, exposed, nullptr);
+    for (const QRect& strip : exposed) {
+        composeScene(strip);
+    }
     update();
 }
 
+void Layer::scrollCache(QImage& cache, const QPoint& delta, const QRegion& exposed,
+    const std::function<void(QPainter&, const QRect&)>& redraw) {
+    if (cache.isNull()) {
+        return;
+    }
+    QImage scrolled(cache.size(), cache.format());
+    scrolled.setDevicePixelRatio(cache.devicePixelRatio());
+    scrolled.fill(Qt::transparent);
+    QPainter painter(&scrolled);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(QPoint(delta), cache);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    if (redraw) {
+        for (const QRect& strip : exposed) {
+            painter.setClipRect(strip);
+            redraw(painter, strip);
+        }
+    }
+    painter.end();
+    cache = scrolled;
+}
+
+//ƽ
+void Layer::moveSelectedShape(QPoint translationVector) {
+    PROFILE_SCOPE("Layer::moveSelectedShape");
+    moveShape(selectedShapeId, translationVector);
+}
+
+void Layer::moveShape(int id, const QPoint& offset) {
+    if (shapes.indexOf(id) < 0 || offset.isNull()) {
+        return;
+    }
+    translateShape(id, offset);
+
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::MoveShape;
+    edit.id = id;
+    edit.offset = offset;
+    history.record(std::move(edit));
+}
+
+void Layer::translateShape(int id, const QPoint& offset) {
+    //߶ΡԲĶͳһţֱӶȫԭƽ
+    int index = shapes.indexOf(id);
+    if (index >= 0) {
+        const QRect frameBefore = isSelected(id) ? selectionBounds() : QRect();
+        QRect oldBounds = shapes.boundsAt(index);
+        shapes.translate(index, offset);
+        lod.remove(id);
+        stats.move(oldBounds, shapes.boundsAt(index));
+        grid.move(id, oldBounds, shapes.boundsAt(index));
+        invalidateScene(oldBounds);
+        invalidateScene(shapes.boundsAt(index));
+        if (!frameBefore.isNull()) {
+            updateSelectionFrame(frameBefore);
+        }
+    }
+}
+
 //ɫ
 void Layer::changeShapeColor(const QColor& newColor) {
-    if (selectedShapeType == NoneType) {
+    int index = shapes.indexOf(selectedShapeId);
+    if (index < 0) {
         QMessageBox::information(this, "No Shape Selected", "Please right-click on a shape first.");
         return;
     }
 
-    //ͼϸ
-    //ͼεʵֶͼεĲ
-    switch (selectedShapeType) {
-    case LineType:
-        if (selectedShapeIndex >= 0 && selectedShapeIndex < lines.size()) {  
-                lineColors[selectedShapeIndex] = newColor;
-        }
+    //еͼڶѡʱıѡɫ
+    if (selectedIds.size() > 1 && isSelected(selectedShapeId)) {
+        setShapesColor(selectedIds, newColor);
+    }
+    else {
+        setShapeColor(selectedShapeId, newColor);
+    }
+
+    selectedShapeId = -1;
+}
+
+void Layer::setShapeColor(int id, const QColor& color) {
+    //ͼεIDҵ±꣬޸ʽ
+    int index = shapes.indexOf(id);
+    if (index < 0) {
+        return;
+    }
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::RecolorShape;
+    edit.id = id;
+    edit.oldStyle = shapes.styleAt(index);
+    edit.newStyle = shapes.styleIndex(color);
+    if (edit.oldStyle == edit.newStyle) {
+        return;
+    }
+    restyleShape(id, edit.newStyle);
+    history.record(std::move(edit));
+}
+
+void Layer::restyleShape(int id, int style) {
+    int index = shapes.indexOf(id);
+    if (index >= 0) {
+        const int oldStyle = shapes.styleAt(index);
+        shapes.setStyle(index, style);
+        renderList.restyle(shapes, index);
+        stats.restyle(shapes, index, oldStyle);
+        invalidateScene(shapes.boundsAt(index));
+    }
+}
+
+//ǳ
+void Layer::recordAdd(int id) {
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::AddShape;
+    edit.id = id;
+    history.record(std::move(edit));
+}
+
+//ӣͼĩβɾѼɫڼ¼
+void Layer::removeLastShape(EditHistory::Edit& edit) {
+    const int index = shapes.indexOf(edit.id);
+    if (index < 0 || index != shapes.size() - 1) {
+        return;
+    }
+    const QRect bounds = shapes.boundsAt(index);
+    edit.type = shapes.typeAt(index);
+    edit.color = shapes.colorAt(index);
+    if (edit.type == ShapeStore::StrokeType) {
+        shapes.decodeStroke(index, edit.points);
+    }
+    else {
+        const PointSpan geometry = shapes.span(index);
+        edit.points = QVector<QPoint>(geometry.begin(), geometry.end());
+    }
+
+    grid.remove(edit.id, bounds);
+    lod.remove(edit.id);
+    renderList.removeLast();
+    stats.remove(shapes, index);
+    shapes.removeLast();
+    if (selectedShapeId == edit.id) {
+        selectedShapeId = -1;
+    }
+    if (isSelected(edit.id)) {
+        QVector<int> ids = selectedIds;
+        ids.removeOne(edit.id);
+        setSelection(ids);
+    }
+    invalidateScene(bounds);
+}
+
+//ӣʱ˸ͼεID¼еIDӣ¼ҵ
+void Layer::restoreShape(const EditHistory::Edit& edit) {
+    const QPoint* points = edit.points.constData();
+    const int count = edit.points.size();
+    int id = -1;
+    switch (edit.type) {
+    case ShapeStore::LineType: {
+        const QLine line(points[0], points[1]);
+        id = shapes.addLine(line, edit.color, calculateLineLength(line), edit.id);
+        break;
+    }
+    case ShapeStore::PolylineType:
+        id = shapes.addPolyline(points, count, edit.color, calculatePolylineLength(points, count), edit.id);
+        break;
+    case ShapeStore::EllipseType: {
+        const QRect rect(points[0], points[1]);
+        id = shapes.addEllipse(rect, edit.color, calculateEllipseArea(rect), edit.id);
         break;
+    }
+    case ShapeStore::StrokeType:
+        id = shapes.addStroke(points, count, edit.color, calculatePolylineLength(points, count), edit.id);
+        break;
+    default:
+        return;
+    }
+    if (id < 0) {
+        return;
+    }
+    indexShape(id);
+    invalidateScene(shapes.boundsAt(shapes.indexOf(id)));
+}
 
-    case PolylineType:
-        if (selectedShapeIndex >= 0 && selectedShapeIndex < polylines.size()) {
-                polylineColors[selectedShapeIndex] = newColor;
-        }
+///գ¼еͼβֿ⻥ؽ
+void Layer::swapScene(ShapeStore& scene) {
+    std::swap(shapes, scene);
+    grid.build(shapes);
+    lod.clear();
+    renderList.rebuild(shapes);
+    stats.rebuild(shapes);
+    selectedShapeId = -1;
+    selectedIds.clear();
+    invalidateLayer(activeLayer);
+}
+
+void Layer::undo() {
+    EditHistory::Edit edit;
+    if (!history.takeUndo(edit)) {
+        return;
+    }
+    switch (edit.kind) {
+    case EditHistory::Edit::AddShape:
+        removeLastShape(edit);
+        break;
+    case EditHistory::Edit::MoveShape:
+        translateShape(edit.id, -edit.offset);
+        break;
+    case EditHistory::Edit::RecolorShape:
+        restyleShape(edit.id, edit.oldStyle);
         break;
+    case EditHistory::Edit::ClearShapes:
+        swapScene(*edit.scene);
+        break;
+    case EditHistory::Edit::MoveShapes:
+        translateShapes(edit.ids, -edit.offset);
+        break;
+    case EditHistory::Edit::RecolorShapes:
+        restoreStyles(edit.ids, edit.oldStyles);
+        break;
+    case EditHistory::Edit::RemoveShapes:
+        reinsertShapes(edit);
+        break;
+    case EditHistory::Edit::AppendShapes:
+        withdrawShapes(edit);
+        break;
+    }
+    history.pushRedo(std::move(edit));
+}
 
-    case EllipseType:
-        if (selectedShapeIndex >= 0 && selectedShapeIndex < ellipses.size()) {
-                ellipseColors[selectedShapeIndex] = newColor;
-        }
+void Layer::redo() {
+    EditHistory::Edit edit;
+    if (!history.takeRedo(edit)) {
+        return;
+    }
+    switch (edit.kind) {
+    case EditHistory::Edit::AddShape:
+        restoreShape(edit);
+        edit.points = QVector<QPoint>();
+        break;
+    case EditHistory::Edit::MoveShape:
+        translateShape(edit.id, edit.offset);
+        break;
+    case EditHistory::Edit::RecolorShape:
+        restyleShape(edit.id, edit.newStyle);
+        break;
+    case EditHistory::Edit::ClearShapes:
+        swapScene(*edit.scene);
+        break;
+    case EditHistory::Edit::MoveShapes:
+        translateShapes(edit.ids, edit.offset);
         break;
+    case EditHistory::Edit::RecolorShapes:
+        restyleShapes(edit.ids, edit.newStyle);
+        break;
+    case EditHistory::Edit::RemoveShapes:
+        removeShapes(edit.positions);
+        break;
+    case EditHistory::Edit::AppendShapes:
+        reinsertShapes(edit);
+        edit.scene.reset();
+        edit.positions = QVector<int>();
+        break;
+    }
+    history.pushUndo(std::move(edit));
+}
 
-    default:
-        QMessageBox::information(this, "Shape Not Found", "No shape found at the selected position.");
+//Ƕѡ༭
+bool Layer::isSelected(int id) const {
+    return std::binary_search(selectedIds.constBegin(), selectedIds.constEnd(), id);
+}
+
+//ѡͼΰΧеĲ꣩
+QRect Layer::selectionBounds() const {
+    QRect bounds;
+    for (int id : selectedIds) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0) {
+            bounds |= shapes.boundsAt(index);
+        }
+    }
+    return bounds;
+}
+
+//仯ʱˢ¾ڵ
+void Layer::updateSelectionFrame(const QRect& before) {
+    updateArea(before);
+    updateArea(selectionBounds());
+}
+
+void Layer::setSelection(const QVector<int>& ids) {
+    const QRect before = selectionBounds();
+    selectedIds = ids;
+    std::sort(selectedIds.begin(), selectedIds.end());
+    selectedIds.erase(std::unique(selectedIds.begin(), selectedIds.end()), selectedIds.end());
+    updateSelectionFrame(before);
+}
+
+void Layer::clearSelection() {
+    setSelection(QVector<int>());
+}
+
+void Layer::selectArea(const QRect& area, bool extend) {
+    grid.collect(shapes, area, shapeCandidates);
+    QVector<int> ids = extend ? selectedIds : QVector<int>();
+    for (int index : shapeCandidates) {
+        if (area.contains(shapes.boundsAt(index))) {
+            ids.append(shapes.idAt(index));
+        }
+    }
+    setSelection(ids);
+}
+
+void Layer::moveShapes(const QVector<int>& ids, const QPoint& offset) {
+    if (offset.isNull()) {
         return;
     }
+    QVector<int> moved;
+    moved.reserve(ids.size());
+    for (int id : ids) {
+        if (shapes.indexOf(id) >= 0) {
+            moved.append(id);
+        }
+    }
+    if (moved.isEmpty()) {
+        return;
+    }
+    std::sort(moved.begin(), moved.end());
+    translateShapes(moved, offset);
 
-    selectedShapeType = NoneType;
-    selectedShapeIndex = -1;
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::MoveShapes;
+    edit.offset = offset;
+    edit.ids = moved;
+    history.record(std::move(edit));
+}
 
-    update();
+void Layer::setShapesColor(const QVector<int>& ids, const QColor& color) {
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::RecolorShapes;
+    edit.newStyle = shapes.styleIndex(color);
+    for (int id : ids) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0 && shapes.styleAt(index) != edit.newStyle) {
+            edit.ids.append(id);
+            edit.oldStyles.append(shapes.styleAt(index));
+        }
+    }
+    if (edit.ids.isEmpty()) {
+        return;
+    }
+    restyleShapes(edit.ids, edit.newStyle);
+    history.record(std::move(edit));
+}
+
+//ɾһͼΣɾͼ볷¼һѹֿ
+void Layer::deleteShapes(const QVector<int>& ids) {
+    QVector<int> indices;
+    indices.reserve(ids.size());
+    for (int id : ids) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0) {
+            indices.append(index);
+        }
+    }
+    if (indices.isEmpty()) {
+        return;
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    EditHistory::Edit edit;
+    edit.kind = EditHistory::Edit::RemoveShapes;
+    edit.ids.reserve(indices.size());
+    for (int index : indices) {
+        edit.ids.append(shapes.idAt(index));
+    }
+    edit.positions = indices;
+    edit.scene = QSharedPointer<ShapeStore>::create(shapes.extract(indices));
+    removeShapes(indices);
+    history.record(std::move(edit));
+}
+
+//׷ӣɾһ׷ӵͼδ¼ѹֿ⣬ʱԭIDŻԭĲ
+void Layer::withdrawShapes(EditHistory::Edit& edit) {
+    QVector<int> indices;
+    indices.reserve(edit.ids.size());
+    for (int id : edit.ids) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0) {
+            indices.append(index);
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    edit.ids.clear();
+    for (int index : indices) {
+        edit.ids.append(shapes.idAt(index));
+    }
+    edit.positions = indices;
+    edit.scene = QSharedPointer<ShapeStore>::create(shapes.extract(indices));
+    removeShapes(indices);
+}
+
+//бͳȥͼκѹֿ⣬indices 
+void Layer::removeShapes(const QVector<int>& indices) {
+    QRect dirty;
+    QVector<int> removed;
+    removed.reserve(indices.size());
+    for (int index : indices) {
+        const int id = shapes.idAt(index);
+        const QRect& bounds = shapes.boundsAt(index);
+        grid.remove(id, bounds);
+        lod.remove(id);
+        stats.remove(shapes, index);
+        dirty |= bounds;
+        removed.append(id);
+    }
+    shapes.remove(indices);
+    renderList.remove(indices);
+
+    std::sort(removed.begin(), removed.end());
+    if (std::binary_search(removed.begin(), removed.end(), selectedShapeId)) {
+        selectedShapeId = -1;
+    }
+    QVector<int> kept;
+    for (int id : selectedIds) {
+        if (!std::binary_search(removed.begin(), removed.end(), id)) {
+            kept.append(id);
+        }
+    }
+    if (kept.size() != selectedIds.size()) {
+        setSelection(kept);
+    }
+    invalidateScene(dirty);
+}
+
+//ɾɾͼԭIDŻԭĲ
+void Layer::reinsertShapes(const EditHistory::Edit& edit) {
+    shapes.reinsert(*edit.scene, edit.ids, edit.positions);
+    QRect dirty;
+    for (int id : edit.ids) {
+        const int index = shapes.indexOf(id);
+        const QRect& bounds = shapes.boundsAt(index);
+        grid.insert(id, bounds);
+        stats.add(shapes, index);
+        dirty |= bounds;
+    }
+    renderList.insert(shapes, edit.positions);
+    invalidateScene(dirty);
+}
+
+//ƽƣƽƺֻػһ
+void Layer::translateShapes(const QVector<int>& ids, const QPoint& offset) {
+    const QRect frameBefore = selectedIds.isEmpty() ? QRect() : selectionBounds();
+    QVector<int> indices;
+    indices.reserve(ids.size());
+    QRect dirty;
+    for (int id : ids) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0) {
+            indices.append(index);
+            dirty |= shapes.boundsAt(index);
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+
+    shapes.translate(indices, offset);
+    for (int index : indices) {
+        const int id = shapes.idAt(index);
+        const QRect& bounds = shapes.boundsAt(index);
+        grid.move(id, bounds.translated(-offset), bounds);
+        stats.move(bounds.translated(-offset), bounds);
+        lod.remove(id);
+        dirty |= bounds;
+    }
+    invalidateScene(dirty);
+    if (!frameBefore.isNull()) {
+        updateSelectionFrame(frameBefore);
+    }
+}
+
+void Layer::restyleShapes(const QVector<int>& ids, int style) {
+    QVector<int> indices;
+    QVector<int> oldStyles;
+    indices.reserve(ids.size());
+    oldStyles.reserve(ids.size());
+    QRect dirty;
+    for (int id : ids) {
+        const int index = shapes.indexOf(id);
+        if (index >= 0) {
+            indices.append(index);
+            oldStyles.append(shapes.styleAt(index));
+            dirty |= shapes.boundsAt(index);
+        }
+    }
+    shapes.setStyle(indices, style);
+    renderList.restyle(shapes, indices);
+    for (int k = 0; k < indices.size(); ++k) {
+        stats.restyle(shapes, indices[k], oldStyles[k]);
+    }
+    invalidateScene(dirty);
+}
+
+void Layer::restoreStyles(const QVector<int>& ids, const QVector<int>& styles) {
+    QVector<int> indices;
+    indices.reserve(ids.size());
+    QRect dirty;
+    for (int k = 0; k < ids.size(); ++k) {
+        const int index = shapes.indexOf(ids[k]);
+        if (index >= 0) {
+            const int oldStyle = shapes.styleAt(index);
+            shapes.setStyle(index, styles[k]);
+            stats.restyle(shapes, index, oldStyle);
+            dirty |= shapes.boundsAt(index);
+            indices.append(index);
+        }
+    }
+    renderList.restyle(shapes, indices);
+    invalidateScene(dirty);
+}
+
+//΢ѡеͼΣס Shift ÿƶ 10 λEsc ȡѡ
+void Layer::keyPressEvent(QKeyEvent* event) {
+    const int step = event->modifiers().testFlag(Qt::ShiftModifier) ? 10 : 1;
+    QPoint offset;
+    switch (event->key()) {
+    case Qt::Key_Left:
+        offset = QPoint(-step, 0);
+        break;
+    case Qt::Key_Right:
+        offset = QPoint(step, 0);
+        break;
+    case Qt::Key_Up:
+        offset = QPoint(0, -step);
+        break;
+    case Qt::Key_Down:
+        offset = QPoint(0, step);
+        break;
+    case Qt::Key_Escape:
+        clearSelection();
+        return;
+    case Qt::Key_Delete:
+    case Qt::Key_Backspace:
+        if (selectedIds.isEmpty()) {
+            QWidget::keyPressEvent(event);
+            return;
+        }
+        deleteShapes(selectedIds);
+        return;
+    default:
+        QWidget::keyPressEvent(event);
+        return;
+    }
+    if (selectedIds.isEmpty()) {
+        QWidget::keyPressEvent(event);
+        return;
+    }
+    moveShapes(selectedIds, offset);
 }
@@ -11,69 +11,270 @@
 #include "MoveDialog.h"
 #include <QColor>
 #include <QColorDialog>
+#include <QTransform>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "ShapeStore.h"
+#include "SpatialGrid.h"
+#include "SceneRenderer.h"
+#include "PolylineLod.h"
+#include "EditHistory.h"
+#include "RenderList.h"
+#include "SceneStatistics.h"
+#include "GeometryKernels.h"
+#include "Profiler.h"
+#include "StrokeSimplifier.h"
+#include <vector>
+#include <functional>
 
 class Layer : public QWidget {
     Q_OBJECT
 
 public:
     enum DrawMode { 
-        None, Line, Polyline, Ellipse, Select, Move, ChangeColor };
-
-    enum ShapeType {
-        NoneType,
-        LineType,
-        PolylineType,
-        EllipseType
-    };
+        None, Line, Polyline, Ellipse, Select, Move, ChangeColor, Freehand };
 
     explicit Layer(QWidget* parent = nullptr);
     void addWidget(QWidget* widget);
     void clear();
     void setDrawMode(DrawMode mode);
-    void setImage(const QImage& img); 
+    void setBackground(const QSharedPointer<TiledImage>& tiled);
+    //ǰʾСԤ쵽ԭͼߴ size ƣsetBackground ʱ
+    void setPreview(const QImage& preview, const QSize& size);
+
+    //ͼΣͬʱ㳤ȡάռͼID
+    int addLine(const QLine& line, const QColor& color);
+    int addPolyline(const QVector<QPoint>& points, const QColor& color);
+    int addPolyline(const QPoint* points, int count, const QColor& color);
+    int addEllipse(const QRect& rect, const QColor& color);
+    //ֻʼpoints ΪѼ򻯵Ķ
+    int addStroke(const QVector<QPoint>& points, const QColor& color);
+
+    //вԣɸȷжϣͼIDҲ -1
+    int hitTest(const QPoint& point, qreal tolerance) const;
+
+    //ͼIDƽơɫͬά뻺棬볷ʷ
+    void moveShape(int id, const QPoint& offset);
+    void setShapeColor(int id, const QColor& color);
+
+    //ѡѡ area ͼΣextend Ϊʱѡ
+    void selectArea(const QRect& area, bool extend);
+    void setSelection(const QVector<int>& ids);
+    void clearSelection();
+    const QVector<int>& selection() const { return selectedIds; }
+
+    //ƽơɫһαɣϲΪһػ򣬲Ϊһ¼д볷ʷ
+    void moveShapes(const QVector<int>& ids, const QPoint& offset);
+    void setShapesColor(const QVector<int>& ids, const QColor& color);
+    //ɾͼΣֿԭѹɾͼ볷¼ʱԭĲηŻ
+    void deleteShapes(const QVector<int>& ids);
+
+    ///ÿֻӦһ¼
+    void undo();
+    void redo();
+    bool canUndo() const { return history.canUndo(); }
+    bool canRedo() const { return history.canRedo(); }
+    void setHistoryLimit(qint64 bytes) { history.setMemoryLimit(bytes); }
+
+    qreal calculateLineLength(const QLine& line) const;
+    qreal calculatePolylineLength(const QPoint* polyline, int count) const;
+    qreal calculateEllipseArea(const QRect& rect) const;
+
+    SceneSnapshot snapshot() const;
+
+    //׷һͼΣ絼ʱʹͼֱӻڻ涥㣻ɳ
+    void appendShapes(const ShapeStore& batch);
+
+    //滻ͼΣӳļ룩ؽռ
+    void setShapes(const ShapeStore& store);
+    const ShapeStore& shapeStore() const { return shapes; }
+
+    //ǰͼĻܣ߳Բͼ༭άлͼΪͼ
+    const SceneStatistics& layerStatistics() const { return stats; }
+    SceneStatistics::StyleTotals layerStatisticsFor(const QColor& color) const;
+    QRect layerBounds() const { return stats.bounds(); }
+    //ĵȫͼ㣬صͼ㣩ĻܣɸͼĻӣʱֻͼй
+    SceneStatistics::StyleTotals documentTotals() const;
+    SceneStatistics::StyleTotals statisticsFor(const QColor& color) const;
+    QRect sceneBounds() const;
+
+    //ͼ㣺¶Уơвԡѡ񡢳ͳֻڵǰͼ
+    //ÿͼ㻺ԼĹդɱɼͼĻ水͸Ⱥϳɣ༭ֻػǰͼ
+    int layerCount() const { return int(layers.size()); }
+    int currentLayer() const { return activeLayer; }
+    void setCurrentLayer(int index);
+    //ڵǰͼ֮½ͼ㲢Ϊǰͼ㣬λ
+    int addLayer(const QString& name);
+    //ɾͼ㣨ɳٱһ
+    void removeLayer(int index);
+    void moveLayer(int from, int to);
+    QString layerName(int index) const { return layers[index].name; }
+    void setLayerName(int index, const QString& name);
+    bool isLayerVisible(int index) const { return layers[index].visible; }
+    void setLayerVisible(int index, bool visible);
+    qreal layerOpacity(int index) const { return layers[index].opacity; }
+    void setLayerOpacity(int index, qreal opacity);
+    //ɼͼ¶ϺϲΪһͼβֿ⣬ֵֻ֧ͼĳļ棻صͼ㲻
+    ShapeStore mergedShapes() const;
+
+    //ͼ任 =  * zoom + panͼԤ泡
+    QTransform viewTransform() const;
+    QPoint mapToScene(const QPoint& widgetPos) const;
+    void resetView();
+
+    //ܸ㣺Ͻʾһ֡ʱػʱ뱻޳ͼԼ
+    void setOverlayVisible(bool visible);
+    bool isOverlayVisible() const { return overlayVisible; }
+
+signals:
+    void layersChanged();
 
 protected:
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
 
 private:
-    QImage image;
-    ShapeType selectedShapeType; 
-    int selectedShapeIndex;
+    QSharedPointer<TiledImage> background;//ֻɼΧķֿ鱳
+    QImage preview;
+    QSize previewSize;
+    QImage sceneCache;//ͼ㻺ĺϳɽ豸رȷ
+    bool sceneCacheValid;
+    QImage backgroundCache;
+    bool backgroundCacheValid;
+    int selectedShapeId;
+    QVector<int> selectedIds;//еѡͼID
+    QRect selectionBounds() const;
+    bool isSelected(int id) const;
+    void updateSelectionFrame(const QRect& before);
 
     DrawMode drawMode;
     bool drawing;
     QPoint startPoint;
     QPoint endPoint;
     QVBoxLayout* layout;
-    QVector<QLine> lines;
-    QVector<QPolygon> polylines;
-    QVector<QRect> ellipses;
-    QVector<QPoint> currentPolylinePoints;//洢Ƶͼ
+    //ͼդ棻ǰͼͼΡʷĳԱУлͼʱλ
+    struct SceneLayer {
+        QString name;
+        bool visible = true;
+        qreal opacity = 1.0;
+        ShapeStore shapes;
+        SpatialGrid grid;
+        PolylineLod lod;
+        RenderList renderList;
+        SceneStatistics stats;
+        EditHistory history;
+        QImage cache;//ͼΪʱ
+        bool cacheValid = false;
+    };
+    std::vector<SceneLayer> layers;
+    int activeLayer;
+    void swapActiveData(SceneLayer& slot);
+    const ShapeStore& shapesOf(int index) const;
+    const SceneStatistics& statsOf(int index) const;
+    void clearShapes();
 
-    QVector<qreal> lineLengths;
-    QVector<qreal> polylineLengths;
-    QVector<qreal> ellipseAreas;//洢ͼεĳȡ
+    ShapeStore shapes;//洢Ƶͼμ䳤ȡԺɫ
+    SpatialGrid grid;
+    PolylineLod lod;//ߵĶ༶򻯣Ļ
+    RenderList renderList;//˳ֶεĻб༭ά
+    SceneStatistics stats;
+    EditHistory history;
+    mutable QVector<int> shapeCandidates;
+    mutable SegmentBatch hitLines;//ваռĺѡ߶Բ
+    mutable EllipseBatch hitEllipses;
+    QVector<qreal> batchMetrics;
+    QVector<QPoint> currentPolylinePoints;
+    StrokeSimplifier stroke;//ڻƵıʼƶ¼
+    mutable QVector<QPoint> strokePoints;//ʼõʱ
+    QColor currentColor;
 
     QPoint selectedPoint;
     DrawMode moveMode = None;
 
+    //ƽƣԹΪţм޻ͼģʽ϶ƽ
+    qreal zoom;
+    QPointF pan;
+    bool panning;
+    QPoint panAnchor;
+    void zoomAt(const QPointF& anchor, qreal factor);
+    void scrollView(const QPoint& delta);
+
+    //ƶϲƶ¼ֻλۼƵƽÿʾ֡ӦһΣ
+    //Ԥֻˢ¾ɡΧͷǰӦδƶ
+    QTimer moveTimer;
+    QElapsedTimer lastMoveFrame;
+    QPoint pendingMovePos;
+    bool movePending;
+    QPoint pendingPan;
+    QRect pendingDirty;//ʼԤдˢµķΧ꣩
+    int frameInterval() const;
+    void scheduleMove();
+    void flushMove();
+    QRect sceneArea(const QRect& widgetArea) const;
+    QRect widgetArea(const QRect& sceneBounds) const;
+
     void moveSelectedShape(QPoint translationVector);
 
-    void showShapeProperties(const QString& shapeType, qreal property);
+    //ӵͼεǼǵռбͳ
+    void indexShape(int id);
 
-    qreal calculateLineLength(const QLine& line) const;
-    qreal calculatePolylineLength(const QPolygon& polyline) const;
-    qreal calculateEllipseArea(const QRect& rect) const;
+    //¼ʷĵײ༭/ʹ
+    void recordAdd(int id);
+    void translateShape(int id, const QPoint& offset);
+    void restyleShape(int id, int style);
+    void translateShapes(const QVector<int>& ids, const QPoint& offset);
+    void restyleShapes(const QVector<int>& ids, int style);
+    void restoreStyles(const QVector<int>& ids, const QVector<int>& styles);
+    void removeShapes(const QVector<int>& indices);
+    void reinsertShapes(const EditHistory::Edit& edit);
+    void withdrawShapes(EditHistory::Edit& edit);
+    void removeLastShape(EditHistory::Edit& edit);
+    void restoreShape(const EditHistory::Edit& edit);
+    void swapScene(ShapeStore& scene);
+
+    //ֲػ棺ʿչֻˢӰ򣬲Ϊ
+    static const int PenWidth = SceneRenderer::PenWidth;
+    QRect previewBounds() const;
+    void updateArea(const QRect& bounds);
+    void invalidateScene(const QRect& bounds);
+
+    //棺exposed Ϊ
+    void ensureSceneCache();
+    void invalidateCaches();
+    void invalidateLayer(int index);
+    QImage allocateCache() const;
+    void ensureBackgroundCache();
+    void ensureLayerCache(int index);
+    void composeScene(const QRect& exposed);
+    void scrollCache(QImage& cache, const QPoint& delta, const QRegion& exposed,
+        const std::function<void(QPainter&, const QRect&)>& redraw);
+    void drawBackground(QPainter& painter, const QRect& exposed);
+    void drawLayer(QPainter& painter, const QRect& exposed, int index);
 
-    bool isPointNearLine(const QPoint& point, const QLine& line, qreal tolerance) const;
-    bool isPointInPolygon(const QPoint& point, const QPolygon& polygon) const;
+    //ļͼΪһ֡ػʱۼƣԴ򿪸ۼ
+    struct FrameStats {
+        qint64 frameNs = 0;
+        int drawn = 0;
+        int culled = 0;
+        qint64 sceneHits = 0;
+        qint64 sceneMisses = 0;
+        qint64 layerHits = 0;
+        qint64 layerMisses = 0;
+    };
+    bool overlayVisible;
+    FrameStats frameStats;
+    int pendingDrawn;
+    int pendingCulled;
+    QRect overlayRect() const;
+    void drawOverlay(QPainter& painter);
+
+    void showShapeProperties(const QString& shapeType, qreal property);
 
-    QVector<QColor> lineColors;
-    QVector<QColor> polylineColors;
-    QVector<QColor> ellipseColors;//洢ͼεɫ
+    bool isPointInPolygon(const QPoint& point, const PointSpan& polygon) const;
 
     void changeShapeColor(const QColor& newColor);
 };
@@ -0,0 +1,114 @@
+#include "LayerPanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+
+LayerPanel::LayerPanel(QWidget* parent)
+    : QWidget(parent), refreshing(false) {
+
+    list = new QListWidget(this);
+    opacitySlider = new QSlider(Qt::Horizontal, this);
+    opacitySlider->setRange(0, 100);
+    addButton = new QPushButton("New", this);
+    removeButton = new QPushButton("Delete", this);
+    upButton = new QPushButton("Up", this);
+    downButton = new QPushButton("Down", this);
+
+    QHBoxLayout* opacityLayout = new QHBoxLayout();
+    opacityLayout->addWidget(new QLabel("Opacity"));
+    opacityLayout->addWidget(opacitySlider);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(addButton);
+    buttonLayout->addWidget(removeButton);
+    buttonLayout->addWidget(upButton);
+    buttonLayout->addWidget(downButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(list);
+    mainLayout->addLayout(opacityLayout);
+    mainLayout->addLayout(buttonLayout);
+    setLayout(mainLayout);
+
+    connect(list, &QListWidget::currentRowChanged, this, [this](int row) {
+        if (!refreshing && canvas && row >= 0) {
+            canvas->setCurrentLayer(layerAt(row));
+        }
+    });
+    connect(list, &QListWidget::itemChanged, this, [this](QListWidgetItem* item) {
+        if (refreshing || !canvas) {
+            return;
+        }
+        const int index = layerAt(list->row(item));
+        canvas->setLayerVisible(index, item->checkState() == Qt::Checked);
+        canvas->setLayerName(index, item->text());
+    });
+    connect(opacitySlider, &QSlider::valueChanged, this, [this](int value) {
+        if (!refreshing && canvas) {
+            canvas->setLayerOpacity(canvas->currentLayer(), value / 100.0);
+        }
+    });
+    connect(addButton, &QPushButton::clicked, this, [this]() {
+        if (canvas) {
+            canvas->addLayer(QString("Layer %1").arg(canvas->layerCount() + 1));
+        }
+    });
+    connect(removeButton, &QPushButton::clicked, this, [this]() {
+        if (canvas) {
+            canvas->removeLayer(canvas->currentLayer());
+        }
+    });
+    connect(upButton, &QPushButton::clicked, this, [this]() {
+        if (canvas) {
+            canvas->moveLayer(canvas->currentLayer(), canvas->currentLayer() + 1);
+        }
+    });
+    connect(downButton, &QPushButton::clicked, this, [this]() {
+        if (canvas) {
+            canvas->moveLayer(canvas->currentLayer(), canvas->currentLayer() - 1);
+        }
+    });
+
+    setCanvas(nullptr);
+}
+
+void LayerPanel::setCanvas(Layer* layer) {
+    if (canvas) {
+        disconnect(canvas, nullptr, this, nullptr);
+    }
+    canvas = layer;
+    if (canvas) {
+        connect(canvas, &Layer::layersChanged, this, &LayerPanel::refresh);
+    }
+    refresh();
+}
+
+int LayerPanel::layerAt(int row) const {
+    return canvas->layerCount() - 1 - row;
+}
+
+int LayerPanel::rowOf(int layer) const {
+    return canvas->layerCount() - 1 - layer;
+}
+
+//ͼؽбڼ䲻ѿؼ仯дػ
+void LayerPanel::refresh() {
+    refreshing = true;
+    list->clear();
+    const bool enabled = !canvas.isNull();
+    setEnabled(enabled);
+    if (enabled) {
+        for (int row = 0; row < canvas->layerCount(); ++row) {
+            const int index = layerAt(row);
+            QListWidgetItem* item = new QListWidgetItem(canvas->layerName(index), list);
+            item->setFlags(item->flags() | Qt::ItemIsUserCheckable | Qt::ItemIsEditable);
+            item->setCheckState(canvas->isLayerVisible(index) ? Qt::Checked : Qt::Unchecked);
+        }
+        list->setCurrentRow(rowOf(canvas->currentLayer()));
+        opacitySlider->setValue(qRound(canvas->layerOpacity(canvas->currentLayer()) * 100));
+        removeButton->setEnabled(canvas->layerCount() > 1);
+        upButton->setEnabled(canvas->currentLayer() < canvas->layerCount() - 1);
+        downButton->setEnabled(canvas->currentLayer() > 0);
+    }
+    refreshing = false;
+}
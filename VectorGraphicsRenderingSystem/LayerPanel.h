@@ -0,0 +1,37 @@
+#ifndef LAYERPANEL_H
+#define LAYERPANEL_H
+
+#include <QWidget>
+#include <QListWidget>
+#include <QPushButton>
+#include <QSlider>
+#include <QPointer>
+#include "Layer.h"
+
+//ͼ壺б϶ʾͼ㣨ϲǰѡƿɼԣ˫
+//ť½ɾơͼ㣬ǰͼĲ͸
+class LayerPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit LayerPanel(QWidget* parent = nullptr);
+
+    //ؽ°
+    void setCanvas(Layer* canvas);
+
+private:
+    void refresh();
+    int layerAt(int row) const;
+    int rowOf(int layer) const;
+
+    QPointer<Layer> canvas;
+    QListWidget* list;
+    QSlider* opacitySlider;
+    QPushButton* addButton;
+    QPushButton* removeButton;
+    QPushButton* upButton;
+    QPushButton* downButton;
+    bool refreshing;
+};
+
+#endif // LAYERPANEL_H
@@ -0,0 +1,222 @@
+#include "PngEncoder.h"
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QThread>
+#include <QtEndian>
+#include <QVector>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef VGRS_HAVE_ZLIB
+#include <zlib.h>
+
+namespace {
+
+//ÿԼԭʼֽ
+const int StripBytes = 1 << 20;
+
+struct Strip {
+    QByteArray deflated;
+    uLong adler = 1;
+    qint64 length = 0;
+    bool ok = false;
+};
+
+int paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+//һгȫ˲ѡȡвֵ֮Сһ֣out[0] Ϊ˲
+void filterRow(const uchar* row, const uchar* prev, int bytes, int bpp, uchar* out, QByteArray& scratch) {
+    scratch.resize(bytes);
+    uchar* candidate = reinterpret_cast<uchar*>(scratch.data());
+    qint64 best = -1;
+    for (int type = 0; type < 5; ++type) {
+        qint64 sum = 0;
+        for (int i = 0; i < bytes; ++i) {
+            const int a = i >= bpp ? row[i - bpp] : 0;
+            const int b = prev ? prev[i] : 0;
+            const int c = prev && i >= bpp ? prev[i - bpp] : 0;
+            int predicted = 0;
+            switch (type) {
+            case 1: predicted = a; break;
+            case 2: predicted = b; break;
+            case 3: predicted = (a + b) / 2; break;
+            case 4: predicted = paeth(a, b, c); break;
+            default: break;
+            }
+            const uchar value = uchar(row[i] - predicted);
+            candidate[i] = value;
+            sum += value < 128 ? value : 256 - value;
+        }
+        if (best < 0 || sum < best) {
+            best = sum;
+            out[0] = uchar(type);
+            memcpy(out + 1, candidate, size_t(bytes));
+        }
+    }
+}
+
+//˲ѹ [first, first + rows) Уһȡǰһ˲뵥̱߳һ
+void encodeStrip(const QImage& image, int first, int rows, bool last, Strip& strip) {
+    const int context = first > 0 ? 1 : 0;
+    const QImage rgb = image.copy(0, first - context, image.width(), rows + context).convertToFormat(QImage::Format_RGB888);
+    if (rgb.isNull()) {
+        return;
+    }
+    const int rowBytes = image.width() * 3;
+    QByteArray filtered(qsizetype(rows) * (rowBytes + 1), Qt::Uninitialized);
+    QByteArray scratch;
+    for (int y = 0; y < rows; ++y) {
+        const uchar* prev = y + context > 0 ? rgb.constScanLine(y + context - 1) : nullptr;
+        filterRow(rgb.constScanLine(y + context), prev, rowBytes, 3,
+            reinterpret_cast<uchar*>(filtered.data()) + qsizetype(y) * (rowBytes + 1), scratch);
+    }
+
+    strip.length = filtered.size();
+    strip.adler = adler32(1L, reinterpret_cast<const Bytef*>(filtered.constData()), uInt(filtered.size()));
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+    strip.deflated.resize(int(deflateBound(&stream, uLong(filtered.size()))) + 64);
+    stream.next_in = reinterpret_cast<Bytef*>(filtered.data());
+    stream.avail_in = uInt(filtered.size());
+    stream.next_out = reinterpret_cast<Bytef*>(strip.deflated.data());
+    stream.avail_out = uInt(strip.deflated.size());
+
+    //мͬˢ½տǣֱӽں
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int rc = Z_OK;
+    for (;;) {
+        rc = deflate(&stream, flush);
+        if (rc == Z_STREAM_ERROR) {
+            break;
+        }
+        const bool done = last ? rc == Z_STREAM_END : stream.avail_out != 0;
+        if (done) {
+            break;
+        }
+        const int used = strip.deflated.size() - int(stream.avail_out);
+        strip.deflated.resize(strip.deflated.size() * 2);
+        stream.next_out = reinterpret_cast<Bytef*>(strip.deflated.data()) + used;
+        stream.avail_out = uInt(strip.deflated.size() - used);
+    }
+    strip.deflated.resize(strip.deflated.size() - int(stream.avail_out));
+    deflateEnd(&stream);
+    strip.ok = rc != Z_STREAM_ERROR;
+}
+
+bool writeChunk(QSaveFile& file, const char* type, const QByteArray& data) {
+    uchar length[4];
+    qToBigEndian(quint32(data.size()), length);
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(data.constData()), uInt(data.size()));
+    uchar checksum[4];
+    qToBigEndian(quint32(crc), checksum);
+    return file.write(reinterpret_cast<const char*>(length), 4) == 4
+        && file.write(type, 4) == 4
+        && file.write(data) == data.size()
+        && file.write(reinterpret_cast<const char*>(checksum), 4) == 4;
+}
+
+}
+
+bool PngEncoder::save(const QImage& image, const QString& filePath, const std::function<void(int done, int total)>& progress) {
+    if (image.isNull()) {
+        return false;
+    }
+    const int rowBytes = image.width() * 3;
+    const int rowsPerStrip = qMax(1, StripBytes / (rowBytes + 1));
+    const int stripCount = (image.height() + rowsPerStrip - 1) / rowsPerStrip;
+    QVector<Strip> strips(stripCount);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    std::atomic<int> done(0);
+    for (int i = 0; i < stripCount; ++i) {
+        const int first = i * rowsPerStrip;
+        const int rows = qMin(rowsPerStrip, image.height() - first);
+        Strip* strip = &strips[i];
+        const bool last = i == stripCount - 1;
+        pool.start([&image, &done, first, rows, last, strip]() {
+            encodeStrip(image, first, rows, last, *strip);
+            ++done;
+        });
+    }
+    while (!pool.waitForDone(50)) {
+        if (progress) {
+            progress(done, stripCount);
+        }
+    }
+    if (progress) {
+        progress(stripCount, stripCount);
+    }
+
+    uLong adler = 1;
+    for (const Strip& strip : strips) {
+        if (!strip.ok) {
+            return false;
+        }
+        adler = adler32_combine(adler, strip.adler, z_off_t(strip.length));
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    static const char Signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+    bool ok = file.write(Signature, 8) == 8;
+
+    QByteArray header(13, '\0');
+    uchar* h = reinterpret_cast<uchar*>(header.data());
+    qToBigEndian(quint32(image.width()), h);
+    qToBigEndian(quint32(image.height()), h + 4);
+    h[8] = 8;//λ
+    h[9] = 2;//RGB
+    ok = ok && writeChunk(file, "IHDR", header);
+
+    //zlib ͷdeflate32K ڣĬϼ𣩷ڵһ IDAT ǰadler32 Уͷһ IDAT β
+    for (int i = 0; i < stripCount && ok; ++i) {
+        QByteArray data;
+        if (i == 0) {
+            data.append('\x78').append('\x9c');
+        }
+        data.append(strips[i].deflated);
+        strips[i].deflated.clear();
+        if (i == stripCount - 1) {
+            uchar trailer[4];
+            qToBigEndian(quint32(adler), trailer);
+            data.append(reinterpret_cast<const char*>(trailer), 4);
+        }
+        ok = writeChunk(file, "IDAT", data);
+    }
+    ok = ok && writeChunk(file, "IEND", QByteArray());
+    return ok && file.commit();
+}
+
+#else
+
+bool PngEncoder::save(const QImage& image, const QString& filePath, const std::function<void(int done, int total)>& progress) {
+    if (progress) {
+        progress(0, 1);
+    }
+    QImageWriter writer(filePath, "png");
+    const bool ok = !image.isNull() && writer.write(image);
+    if (progress) {
+        progress(1, 1);
+    }
+    return ok;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+#include <QImage>
+#include <QString>
+#include <functional>
+
+//߳ PNG 룺ͼгÿ̳߳ж˲ѹΪǵ raw deflate 
+// Z_SYNC_FLUSH βһ Z_FINISH β˳ƴӺһϷ zlib 
+//У adler32_combine ϲÿдһ IDAT 
+//ʱδҵ zlibδ VGRS_HAVE_ZLIB˻ QImageWriter ̱߳
+//Ϊ͸ 8 λ RGBʺϰ׵׵ͼ
+class PngEncoder {
+public:
+    //progress ڵ߳бãΪܵ
+    static bool save(const QImage& image, const QString& filePath,
+        const std::function<void(int done, int total)>& progress = nullptr);
+};
+
+#endif // PNGENCODER_H
@@ -0,0 +1,111 @@
+#include "PolylineLod.h"
+#include "ShapeStore.h"
+#include <QPair>
+
+const qreal PolylineLod::Tolerances[PolylineLod::LevelCount] = { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0 };
+const qreal PolylineLod::MaxDeviceError = 0.5;
+
+//㵽߶εľƽ
+static qreal segmentDistanceSquared(const QPoint& p, const QPoint& a, const QPoint& b) {
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    qreal px = p.x() - a.x();
+    qreal py = p.y() - a.y();
+    const qreal lengthSquared = dx * dx + dy * dy;
+    if (lengthSquared > 0.0) {
+        const qreal t = qBound(qreal(0.0), (px * dx + py * dy) / lengthSquared, qreal(1.0));
+        px -= t * dx;
+        py -= t * dy;
+    }
+    return px * px + py * py;
+}
+
+//Douglas-Peucker 򻯣ʽջݹ飬ⳤߵջ
+QVector<QPoint> PolylineLod::simplify(const QPoint* points, int count, qreal tolerance) {
+    if (count < 3) {
+        return QVector<QPoint>(points, points + count);
+    }
+    const qreal toleranceSquared = tolerance * tolerance;
+    QVector<bool> keep(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    QVector<QPair<int, int>> stack;
+    stack.append(qMakePair(0, count - 1));
+    while (!stack.isEmpty()) {
+        const QPair<int, int> span = stack.takeLast();
+        qreal farthest = 0.0;
+        int split = -1;
+        for (int i = span.first + 1; i < span.second; ++i) {
+            const qreal d = segmentDistanceSquared(points[i], points[span.first], points[span.second]);
+            if (d > farthest) {
+                farthest = d;
+                split = i;
+            }
+        }
+        if (split >= 0 && farthest > toleranceSquared) {
+            keep[split] = true;
+            stack.append(qMakePair(span.first, split));
+            stack.append(qMakePair(split, span.second));
+        }
+    }
+
+    QVector<QPoint> result;
+    for (int i = 0; i < count; ++i) {
+        if (keep[i]) {
+            result.append(points[i]);
+        }
+    }
+    return result;
+}
+
+void PolylineLod::build(const ShapeStore& shapes, int index) {
+    const PointSpan points = shapes.span(index);
+    if (shapes.typeAt(index) != ShapeStore::PolylineType || points.size() < MinPoints) {
+        return;
+    }
+    QVector<QVector<QPoint>> built;
+    built.reserve(LevelCount);
+    for (int k = 0; k < LevelCount; ++k) {
+        built.append(simplify(points.data(), points.size(), Tolerances[k]));
+    }
+    levels.insert(shapes.idAt(index), built);
+}
+
+const QVector<QPoint>* PolylineLod::select(const ShapeStore& shapes, int index, qreal scale) {
+    const int count = shapes.pointCountAt(index);
+    if (count < MinPoints || scale <= 0.0) {
+        return nullptr;
+    }
+
+    //ݲ㵽豸غ󲻳 MaxDeviceError һ
+    int level = -1;
+    for (int k = 0; k < LevelCount; ++k) {
+        if (Tolerances[k] * scale <= MaxDeviceError) {
+            level = k;
+        }
+    }
+    if (level < 0) {
+        return nullptr;
+    }
+
+    const int id = shapes.idAt(index);
+    auto it = levels.constFind(id);
+    if (it == levels.constEnd()) {
+        build(shapes, index);
+        it = levels.constFind(id);
+        if (it == levels.constEnd()) {
+            return nullptr;
+        }
+    }
+    const QVector<QPoint>& points = it.value()[level];
+    return points.size() < count ? &points : nullptr;
+}
+
+void PolylineLod::remove(int id) {
+    levels.remove(id);
+}
+
+void PolylineLod::clear() {
+    levels.clear();
+}
@@ -0,0 +1,36 @@
+#ifndef POLYLINELOD_H
+#define POLYLINELOD_H
+
+#include <QHash>
+#include <QVector>
+#include <QPoint>
+
+class ShapeStore;
+
+//ߵĶ༶򻯣Douglas-PeuckerͼID
+//ֻԶ MinPoints Чݲ߼𼶷
+//ʱ豸ѡ豸صһвԡ뵼ʹԭʼ
+class PolylineLod {
+public:
+    static const int MinPoints = 256;
+
+    //Ԥĳߵĸ򻯽
+    void build(const ShapeStore& shapes, int index);
+    //ʺϵǰŵļ򻯶㣬ʱ nullptrδʱڴ
+    const QVector<QPoint>* select(const ShapeStore& shapes, int index, qreal scale);
+
+    //ͼζıɾʱ仺
+    void remove(int id);
+    void clear();
+
+private:
+    static QVector<QPoint> simplify(const QPoint* points, int count, qreal tolerance);
+
+    QHash<int, QVector<QVector<QPoint>>> levels;
+
+    static const int LevelCount = 6;
+    static const qreal Tolerances[LevelCount];
+    static const qreal MaxDeviceError;
+};
+
+#endif // POLYLINELOD_H
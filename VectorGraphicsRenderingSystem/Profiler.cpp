@@ -0,0 +1,125 @@
+#include "Profiler.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QCoreApplication>
+#include <vector>
+
+std::atomic<bool> Profiler::enabled(false);
+
+namespace {
+
+struct Event {
+    const char* name;
+    qint64 start;
+    qint64 duration;
+    int thread;
+};
+
+QMutex eventMutex;
+std::vector<Event> events;//λnextSlot Ϊһдλ
+int nextSlot = 0;
+
+std::atomic<int> threadCount(0);
+
+//̱߳Ű״μ¼˳䣬ϵͳ߳ ID ̣ʱϱ
+int threadId() {
+    thread_local const int id = ++threadCount;
+    return id;
+}
+
+const QElapsedTimer& monotonicClock() {
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+//Դе԰ JSON ת
+QByteArray quoted(const char* name) {
+    QByteArray out("\"");
+    for (const char* c = name; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        out += *c;
+    }
+    out += '"';
+    return out;
+}
+
+QByteArray micros(qint64 ns) {
+    return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+
+}
+
+qint64 Profiler::now() {
+    return monotonicClock().nsecsElapsed();
+}
+
+void Profiler::setEnabled(bool on) {
+    if (on) {
+        now();//ʱ
+        QMutexLocker locker(&eventMutex);
+        events.clear();
+        events.reserve(1024);
+        nextSlot = 0;
+    }
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+int Profiler::eventCount() {
+    QMutexLocker locker(&eventMutex);
+    return int(events.size());
+}
+
+void Profiler::record(const char* name, qint64 startNs, qint64 durationNs) {
+    const Event event = { name, startNs, durationNs, threadId() };
+    QMutexLocker locker(&eventMutex);
+    if (int(events.size()) < Capacity) {
+        events.push_back(event);
+        return;
+    }
+    events[nextSlot] = event;
+    nextSlot = (nextSlot + 1) % Capacity;
+}
+
+//ÿ¼дһ¼"ph":"X"ʱ䵥λΪ΢
+bool Profiler::exportChromeTrace(const QString& filePath) {
+    std::vector<Event> copy;
+    {
+        QMutexLocker locker(&eventMutex);
+        copy.reserve(events.size());
+        copy.insert(copy.end(), events.begin() + nextSlot, events.end());
+        copy.insert(copy.end(), events.begin(), events.begin() + nextSlot);
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray chunk;
+    chunk.reserve(1 << 16);
+    chunk += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (size_t i = 0; i < copy.size(); ++i) {
+        const Event& event = copy[i];
+        chunk += "{\"name\":" + quoted(event.name)
+            + ",\"cat\":\"vgrs\",\"ph\":\"X\",\"ts\":" + micros(event.start)
+            + ",\"dur\":" + micros(event.duration)
+            + ",\"pid\":" + pid
+            + ",\"tid\":" + QByteArray::number(event.thread) + "}";
+        chunk += i + 1 < copy.size() ? ",\n" : "\n";
+        if (chunk.size() >= (1 << 16)) {
+            file.write(chunk);
+            chunk.clear();
+        }
+    }
+    chunk += "]}\n";
+    file.write(chunk);
+    return file.commit();
+}
@@ -0,0 +1,56 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+//ȵ·ʱPROFILE_SCOPE ʱ¼һκʱɵΪ Chrome trace-event JSONchrome://tracingPerfetto
+//δ¼ʱֻһԭӱ־ȡʱҲ VGRS_NO_PROFILING ʱʱ
+//¼ڹ̶ĻλУ󸲸¼ʱ¼Ҳ
+class Profiler {
+public:
+    static const int Capacity = 1 << 20;
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    //ʼ¼ʱ֮ǰ¼
+    static void setEnabled(bool on);
+    static int eventCount();
+
+    //ʱӣλ
+    static qint64 now();
+    //name Ǿ̬洢ַָֻ
+    static void record(const char* name, qint64 startNs, qint64 durationNs);
+
+    static bool exportChromeTrace(const QString& filePath);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(Profiler::isEnabled() ? name : nullptr), start(this->name ? Profiler::now() : 0) {}
+    ~ProfileScope() {
+        if (name) {
+            Profiler::record(name, start, Profiler::now() - start);
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    qint64 start;
+};
+
+#ifdef VGRS_NO_PROFILING
+#define PROFILE_SCOPE(name) ((void)0)
+#else
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,181 @@
+#include "RenderList.h"
+#include "ShapeStore.h"
+#include "SceneRenderer.h"
+#include <algorithm>
+
+void RenderList::clear() {
+    runs.clear();
+    covered = 0;
+    stale = false;
+}
+
+void RenderList::rebuild(const ShapeStore& shapes) {
+    clear();
+    for (int i = 0; i < shapes.size(); ++i) {
+        add(shapes, i);
+    }
+}
+
+void RenderList::push(QVector<Run>& target, int style, int first, int end) {
+    if (first >= end) {
+        return;
+    }
+    if (!target.isEmpty() && target.last().style == style && target.last().end == first) {
+        target.last().end = end;
+    }
+    else {
+        target.append(Run{ style, first, end });
+    }
+}
+
+int RenderList::runAt(int index) const {
+    auto it = std::upper_bound(runs.constBegin(), runs.constEnd(), index, [](int value, const Run& run) {
+        return value < run.first;
+    });
+    return int(it - runs.constBegin()) - 1;
+}
+
+void RenderList::add(const ShapeStore& shapes, int index) {
+    if (stale || index != covered) {
+        stale = true;
+        return;
+    }
+    push(runs, shapes.styleAt(index), index, index + 1);
+    covered = index + 1;
+}
+
+void RenderList::removeLast() {
+    if (stale || runs.isEmpty()) {
+        stale = true;
+        return;
+    }
+    Run& last = runs.last();
+    if (--last.end == last.first) {
+        runs.removeLast();
+    }
+    --covered;
+}
+
+// index ڵĶΣͬºϲ滻ԭĶ
+void RenderList::restyle(const ShapeStore& shapes, int index) {
+    if (stale || index < 0 || index >= covered) {
+        return;
+    }
+    const int r = runAt(index);
+    const Run run = runs[r];
+    const int style = shapes.styleAt(index);
+    if (run.style == style) {
+        return;
+    }
+    const int lo = qMax(r - 1, 0);
+    const int hi = qMin(r + 1, runs.size() - 1);
+    scratch.clear();
+    if (lo < r) {
+        push(scratch, runs[lo].style, runs[lo].first, runs[lo].end);
+    }
+    push(scratch, run.style, run.first, index);
+    push(scratch, style, index, index + 1);
+    push(scratch, run.style, index + 1, run.end);
+    if (hi > r) {
+        push(scratch, runs[hi].style, runs[hi].first, runs[hi].end);
+    }
+
+    const int replaced = hi - lo + 1;
+    if (scratch.size() < replaced) {
+        runs.remove(lo + scratch.size(), replaced - scratch.size());
+    }
+    else if (scratch.size() > replaced) {
+        runs.insert(lo + replaced, scratch.size() - replaced, Run());
+    }
+    std::copy(scratch.constBegin(), scratch.constEnd(), runs.begin() + lo);
+}
+
+//һαΣֻ𿪺иɫͼεĶ
+void RenderList::restyle(const ShapeStore& shapes, QVector<int> indices) {
+    if (stale || indices.isEmpty()) {
+        return;
+    }
+    if (indices.size() == 1) {
+        restyle(shapes, indices[0]);
+        return;
+    }
+    std::sort(indices.begin(), indices.end());
+    scratch.clear();
+    int k = 0;
+    for (const Run& run : runs) {
+        int first = run.first;
+        for (; k < indices.size() && indices[k] < run.end; ++k) {
+            const int index = indices[k];
+            if (index < first) {
+                continue;
+            }
+            push(scratch, run.style, first, index);
+            push(scratch, shapes.styleAt(index), index, index + 1);
+            first = index + 1;
+        }
+        push(scratch, run.style, first, run.end);
+    }
+    runs.swap(scratch);
+}
+
+//ÿμȥڶڵɾǰƴǰɾյĶαͬɫĶ֮ϲ
+void RenderList::remove(const QVector<int>& indices) {
+    if (stale || indices.isEmpty()) {
+        return;
+    }
+    scratch.clear();
+    int k = 0;
+    for (const Run& run : runs) {
+        const int before = k;
+        while (k < indices.size() && indices[k] < run.end) {
+            ++k;
+        }
+        const int first = run.first - before;
+        push(scratch, run.style, first, first + (run.end - run.first) - (k - before));
+    }
+    covered -= indices.size();
+    runs.swap(scratch);
+}
+
+//positions ǲ±꣺ΰѲ֮ǰĲ֡ͼд
+void RenderList::insert(const ShapeStore& shapes, const QVector<int>& positions) {
+    if (stale || positions.isEmpty()) {
+        return;
+    }
+    scratch.clear();
+    int k = 0;
+    for (const Run& run : runs) {
+        int first = run.first + k;
+        int length = run.end - run.first;
+        for (; k < positions.size() && positions[k] < first + length; ++k) {
+            const int position = positions[k];
+            push(scratch, run.style, first, position);
+            length -= position - first;
+            push(scratch, shapes.styleAt(position), position, position + 1);
+            first = position + 1;
+        }
+        push(scratch, run.style, first, first + length);
+    }
+    for (; k < positions.size(); ++k) {
+        push(scratch, shapes.styleAt(positions[k]), positions[k], positions[k] + 1);
+    }
+    covered += positions.size();
+    runs.swap(scratch);
+}
+
+void RenderList::draw(QPainter& painter, const ShapeStore& shapes, PolylineLod* lod) {
+    if (stale || covered != shapes.size()) {
+        rebuild(shapes);
+    }
+    const qreal scale = lod ? SceneRenderer::deviceScale(painter) : 1.0;
+    for (const Run& run : runs) {
+        painter.setPen(QPen(shapes.colors()[run.style], SceneRenderer::PenWidth));
+        lines.clear();
+        for (int index = run.first; index < run.end; ++index) {
+            SceneRenderer::drawShape(painter, shapes, index, lod, scale, lines, stroke);
+        }
+        if (!lines.isEmpty()) {
+            painter.drawLines(lines.constData(), lines.size());
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef RENDERLIST_H
+#define RENDERLIST_H
+
+#include <QVector>
+#include <QLine>
+#include <QPoint>
+#include <QPainter>
+
+class ShapeStore;
+class PolylineLod;
+
+//˳ֶεĻб±ʽͬͼΪһΣÿֻһλʣ߶һ drawLines ύ
+//ͼɫ뻭ʶͬȺ˳Ӱʾ±һ£˳ֻڵͬɫͼܺϲ
+//༭ֻ»Ӱ±긽ĶΣڶ׷ʱӳһΣɫʱڵĶβκϲ漰Σ
+//ɫɾʱһαΣֻ漰Ķβƽε±ꣻɨʽ
+class RenderList {
+public:
+    void clear();
+    void rebuild(const ShapeStore& shapes);
+
+    //ͼμ붥
+    void add(const ShapeStore& shapes, int index);
+    //ͼαƳǰ
+    void removeLast();
+    //ͼθɫãindices 
+    void restyle(const ShapeStore& shapes, int index);
+    void restyle(const ShapeStore& shapes, QVector<int> indices);
+    //ֿⰴ indices ѹ
+    void remove(const QVector<int>& indices);
+    //ͼηŻزֿãpositions Ϊڵ±꣨
+    void insert(const ShapeStore& shapes, const QVector<int>& positions);
+
+    void draw(QPainter& painter, const ShapeStore& shapes, PolylineLod* lod);
+
+private:
+    struct Run {
+        int style;
+        int first;
+        int end;
+    };
+
+    //׷ӵ target ĩβĩͬɫʱϲ
+    static void push(QVector<Run>& target, int style, int first, int end);
+    //± index Ķ
+    int runAt(int index) const;
+
+    QVector<Run> runs;
+    int covered = 0;//ѷֶεͼ
+    bool stale = false;
+    QVector<Run> scratch;
+    QVector<QLine> lines;
+    QVector<QPoint> stroke;
+};
+
+#endif // RENDERLIST_H
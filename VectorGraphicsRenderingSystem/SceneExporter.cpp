@@ -0,0 +1,90 @@
+#include "SceneExporter.h"
+#include "SpatialGrid.h"
+#include <QThreadPool>
+#include <QThread>
+#include <cmath>
+#include <atomic>
+#include <vector>
+
+SceneExporter::SceneExporter(int tileSize)
+    : tileSize(tileSize) {
+}
+
+QImage SceneExporter::render(const SceneSnapshot& snapshot, qreal scale,
+    const std::function<void(int done, int total)>& progress) const {
+    const QSize outputSize(qRound(snapshot.size.width() * scale), qRound(snapshot.size.height() * scale));
+    if (outputSize.isEmpty()) {
+        return QImage();
+    }
+
+    QImage target(outputSize, QImage::Format_ARGB32_Premultiplied);
+    if (target.isNull()) {
+        return QImage();
+    }
+    target.fill(Qt::white);
+
+    //ڼֻÿͼһÿĿٲü
+    std::vector<SpatialGrid> grids;
+    grids.reserve(snapshot.layers.size());
+    for (const SnapshotLayer& layer : snapshot.layers) {
+        grids.emplace_back(256);
+        grids.back().build(layer.shapes);
+    }
+
+    //߳ȡָ룬⹤߳дͼ
+    uchar* bits = target.bits();
+    const qsizetype bytesPerLine = target.bytesPerLine();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    std::atomic<int> done(0);
+    int total = 0;
+
+    for (int y = 0; y < outputSize.height(); y += tileSize) {
+        for (int x = 0; x < outputSize.width(); x += tileSize) {
+            const QRect tileRect(x, y, qMin(tileSize, outputSize.width() - x), qMin(tileSize, outputSize.height() - y));
+
+            ++total;
+            pool.start([&snapshot, &grids, &done, bits, bytesPerLine, tileRect, scale]() {
+                //ĿͼиÿڴΪ׹ͼֱӻƵλ
+                QImage tile(bits + tileRect.y() * bytesPerLine + tileRect.x() * 4,
+                    tileRect.width(), tileRect.height(), bytesPerLine, QImage::Format_ARGB32_Premultiplied);
+
+                //ÿڳиǵķΧ
+                const QRect logical = QRectF(tileRect.x() / scale, tileRect.y() / scale,
+                    tileRect.width() / scale, tileRect.height() / scale).toAlignedRect();
+
+                QPainter painter(&tile);
+                painter.setRenderHint(QPainter::SmoothPixmapTransform);
+                painter.translate(-tileRect.x(), -tileRect.y());
+                painter.scale(scale, scale);
+
+                if (snapshot.background) {
+                    snapshot.background->draw(painter, logical);
+                }
+
+                const int margin = SceneRenderer::PenWidth;
+                QVector<int> indices;
+                for (int i = 0; i < snapshot.layers.size(); ++i) {
+                    const SnapshotLayer& layer = snapshot.layers[i];
+                    grids[i].collect(layer.shapes, logical.adjusted(-margin, -margin, margin, margin), indices);
+                    if (indices.isEmpty()) {
+                        continue;
+                    }
+                    SceneRenderer::drawLayer(painter, layer.opacity, tile.rect(), [&layer, &indices](QPainter& layerPainter) {
+                        SceneRenderer::drawShapes(layerPainter, layer.shapes, indices);
+                    });
+                }
+                painter.end();
+                ++done;
+            });
+        }
+    }
+    while (!pool.waitForDone(50)) {
+        if (progress) {
+            progress(done, total);
+        }
+    }
+
+    return target;
+}
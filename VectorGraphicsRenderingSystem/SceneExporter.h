@@ -0,0 +1,23 @@
+#ifndef SCENEEXPORTER_H
+#define SCENEEXPORTER_H
+
+#include <QImage>
+#include "SceneRenderer.h"
+#include <functional>
+
+//̵ֿ߳ͼ tileSize п飬ÿ̳߳ж
+//ֱӻƵĿͼлصƴ
+class SceneExporter {
+public:
+    explicit SceneExporter(int tileSize = 1024);
+
+    //űȾգڴ治ʱؿͼ
+    //progress ڵ߳бãΪܵĿ
+    QImage render(const SceneSnapshot& snapshot, qreal scale,
+        const std::function<void(int done, int total)>& progress = nullptr) const;
+
+private:
+    int tileSize;
+};
+
+#endif // SCENEEXPORTER_H
@@ -0,0 +1,211 @@
+#include "SceneFile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+#error "SceneFile stores columns in host byte order and requires a little-endian host"
+#endif
+
+static_assert(sizeof(QPoint) == 2 * sizeof(qint32), "QPoint must be two 32-bit ints");
+static_assert(sizeof(QRect) == 4 * sizeof(qint32), "QRect must be four 32-bit ints");
+static_assert(sizeof(qreal) == sizeof(double), "qreal must be double");
+
+namespace {
+
+struct Header {
+    char magic[4];
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    quint32 shapeCount;
+    quint32 pointCount;
+    quint32 paletteCount;
+    quint32 strokeByteCount;//汾 1 ΪֶΣΪ 0
+};
+static_assert(sizeof(Header) == 32, "unexpected scene header size");
+
+const char Magic[4] = { 'V', 'G', 'R', 'S' };
+const quint32 CurrentVersion = 2;
+
+qint64 padded(qint64 bytes) {
+    return (bytes + 3) & ~qint64(3);
+}
+
+//ļܳȣļͷеļ
+qint64 expectedSize(const Header& header) {
+    const qint64 n = header.shapeCount;
+    return qint64(sizeof(Header))
+        + 4 * qint64(header.paletteCount)
+        + padded(n)
+        + 3 * 4 * n
+        + 16 * n
+        + 8 * n
+        + (header.version >= 2 ? 4 * n : 0)
+        + 8 * qint64(header.pointCount)
+        + padded(header.strokeByteCount);
+}
+
+}
+
+bool SceneFile::save(const QString& filePath, const ShapeStore& shapes, const QSize& size) {
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = CurrentVersion;
+    header.width = size.width();
+    header.height = size.height();
+    header.shapeCount = quint32(shapes.size());
+    header.pointCount = quint32(shapes.points.size());
+    header.paletteCount = quint32(shapes.palette.size());
+    header.strokeByteCount = quint32(shapes.strokeBytes.size());
+
+    QVector<quint32> palette;
+    palette.reserve(shapes.palette.size());
+    for (const QColor& color : shapes.palette) {
+        palette.append(color.rgba());
+    }
+
+    auto write = [&file](const void* data, qint64 bytes) {
+        return bytes == 0 || file.write(static_cast<const char*>(data), bytes) == bytes;
+    };
+    const qint64 n = shapes.size();
+    const char zeros[4] = {};
+
+    //ļ˳д
+    bool ok = write(&header, sizeof(header))
+        && write(palette.constData(), 4 * qint64(palette.size()))
+        && write(shapes.types.constData(), n)
+        && write(zeros, padded(n) - n)
+        && write(shapes.styles.constData(), 4 * n)
+        && write(shapes.offsets.constData(), 4 * n)
+        && write(shapes.counts.constData(), 4 * n)
+        && write(shapes.bounds.constData(), 16 * n)
+        && write(shapes.metrics.constData(), 8 * n)
+        && write(shapes.streamOffsets.constData(), 4 * n)
+        && write(shapes.points.constData(), 8 * qint64(shapes.points.size()))
+        && write(shapes.strokeBytes.constData(), shapes.strokeBytes.size())
+        && write(zeros, padded(shapes.strokeBytes.size()) - shapes.strokeBytes.size());
+
+    return ok && file.commit();
+}
+
+bool SceneFile::load(const QString& filePath, ShapeStore& shapes, QSize& size) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(Header))) {
+        return false;
+    }
+    const uchar* data = file.map(0, fileSize);
+    if (!data) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    //汾 1 ûбʼȡʱͼεıʼƫΪ -1
+    if (header.version == 1) {
+        header.strokeByteCount = 0;
+    }
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version < 1 || header.version > CurrentVersion
+        || header.width < 0 || header.height < 0
+        || header.shapeCount > quint32(std::numeric_limits<int>::max())
+        || header.pointCount > quint32(std::numeric_limits<int>::max())
+        || header.strokeByteCount > quint32(std::numeric_limits<int>::max())
+        || expectedSize(header) != fileSize) {
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+
+    const int n = int(header.shapeCount);
+    const int pointCount = int(header.pointCount);
+    const uchar* cursor = data + sizeof(Header);
+    auto take = [&cursor](void* dest, qint64 bytes) {
+        if (bytes > 0) {
+            std::memcpy(dest, cursor, bytes);
+        }
+        cursor += bytes;
+    };
+
+    ShapeStore loaded;
+    loaded.palette.clear();
+    loaded.palette.reserve(int(header.paletteCount));
+    for (quint32 i = 0; i < header.paletteCount; ++i) {
+        quint32 rgba;
+        take(&rgba, 4);
+        loaded.palette.append(QColor::fromRgba(rgba));
+    }
+
+    //ڴ沼һ£ֱ鿽
+    loaded.types.resize(n);
+    take(loaded.types.data(), n);
+    cursor += padded(n) - n;
+    loaded.styles.resize(n);
+    take(loaded.styles.data(), 4 * qint64(n));
+    loaded.offsets.resize(n);
+    take(loaded.offsets.data(), 4 * qint64(n));
+    loaded.counts.resize(n);
+    take(loaded.counts.data(), 4 * qint64(n));
+    loaded.bounds.resize(n);
+    take(loaded.bounds.data(), 16 * qint64(n));
+    loaded.metrics.resize(n);
+    take(loaded.metrics.data(), 8 * qint64(n));
+    if (header.version >= 2) {
+        loaded.streamOffsets.resize(n);
+        take(loaded.streamOffsets.data(), 4 * qint64(n));
+    }
+    else {
+        loaded.streamOffsets.fill(-1, n);
+    }
+    loaded.points.resize(pointCount);
+    take(loaded.points.data(), 8 * qint64(pointCount));
+    loaded.strokeBytes.resize(int(header.strokeByteCount));
+    take(loaded.strokeBytes.data(), header.strokeByteCount);
+
+    file.unmap(const_cast<uchar*>(data));
+
+    //У±귶Χֹ𻵵ļԽ
+    //ʼ밴ͼ˳ǡ꣬ɾʱԭѹһ
+    const int paletteCount = loaded.palette.size();
+    qint64 nextOffset = 0;
+    qint64 nextStreamOffset = 0;
+    for (int i = 0; i < n; ++i) {
+        const quint8 type = loaded.types[i];
+        const int offset = loaded.offsets[i];
+        const int count = loaded.counts[i];
+        if (type < ShapeStore::LineType || type > ShapeStore::StrokeType
+            || loaded.styles[i] < 0 || loaded.styles[i] >= paletteCount
+            || offset != nextOffset || count < 0 || qint64(offset) + count > pointCount
+            || ((type == ShapeStore::LineType || type == ShapeStore::EllipseType) && count != 2)) {
+            return false;
+        }
+        nextOffset += count;
+        if (type == ShapeStore::StrokeType) {
+            if (count != 1 || loaded.streamOffsets[i] != nextStreamOffset || !loaded.isStrokeValid(i)) {
+                return false;
+            }
+            nextStreamOffset += loaded.strokeByteSizeAt(i);
+        }
+        else if (loaded.streamOffsets[i] != -1) {
+            return false;
+        }
+    }
+    if (nextOffset != pointCount || nextStreamOffset != loaded.strokeBytes.size()) {
+        return false;
+    }
+
+    loaded.resetIds();
+    loaded.rebuildPaletteLookup();
+    shapes = std::move(loaded);
+    size = QSize(header.width, header.height);
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <QString>
+#include <QSize>
+#include "ShapeStore.h"
+
+//ʸļ.vgsС򣬲£
+//  ļͷ   magic "VGRS"汾ߡͼɫʼֽ
+//  ɫ   paletteCount  ARGBquint32
+//       types(quint8뵽 4 ֽ)stylesoffsetscounts(qint32)
+//           bounds(4 x qint32)metrics(double)streamOffsets(qint32)points(2 x qint32)
+//           strokeBytes(뵽 4 ֽ)
+//汾 1 û streamOffsets  strokeBytes УԿɶȡ
+// ShapeStore ڴ沼һ£ȡʱӳļ忽
+class SceneFile {
+public:
+    static bool save(const QString& filePath, const ShapeStore& shapes, const QSize& size);
+    static bool load(const QString& filePath, ShapeStore& shapes, QSize& size);
+};
+
+#endif // SCENEFILE_H
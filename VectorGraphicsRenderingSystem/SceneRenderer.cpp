@@ -0,0 +1,127 @@
+#include "SceneRenderer.h"
+#include "PolylineLod.h"
+#include <cmath>
+
+qreal SceneRenderer::deviceScale(const QPainter& painter) {
+    return std::sqrt(std::abs(painter.deviceTransform().determinant()));
+}
+
+void SceneRenderer::drawPolyline(QPainter& painter, const ShapeStore& shapes, int index, PolylineLod* lod, qreal scale) {
+    const QVector<QPoint>* simplified = lod ? lod->select(shapes, index, scale) : nullptr;
+    if (simplified) {
+        painter.drawPolyline(simplified->constData(), simplified->size());
+    }
+    else {
+        const PointSpan points = shapes.span(index);
+        painter.drawPolyline(points.data(), points.size());
+    }
+}
+
+void SceneRenderer::drawStroke(QPainter& painter, const ShapeStore& shapes, int index, QVector<QPoint>& scratch) {
+    shapes.decodeStroke(index, scratch);
+    painter.drawPolyline(scratch.constData(), scratch.size());
+}
+
+void SceneRenderer::drawShape(QPainter& painter, const ShapeStore& shapes, int index, PolylineLod* lod, qreal scale,
+    QVector<QLine>& lines, QVector<QPoint>& scratch) {
+    switch (shapes.typeAt(index)) {
+    case ShapeStore::LineType:
+        lines.append(shapes.lineAt(index));
+        break;
+    case ShapeStore::PolylineType:
+        drawPolyline(painter, shapes, index, lod, scale);
+        break;
+    case ShapeStore::EllipseType:
+        painter.drawEllipse(shapes.ellipseAt(index));
+        break;
+    case ShapeStore::StrokeType:
+        drawStroke(painter, shapes, index, scratch);
+        break;
+    default:
+        break;
+    }
+}
+
+void SceneRenderer::drawShapes(QPainter& painter, const ShapeStore& shapes, const QVector<int>& indices, PolylineLod* lod) {
+    const qreal scale = lod ? deviceScale(painter) : 1.0;
+    QVector<QLine> lines;
+    QVector<QPoint> stroke;
+    int k = 0;
+    while (k < indices.size()) {
+        const int style = shapes.styleAt(indices[k]);
+        painter.setPen(QPen(shapes.colors()[style], PenWidth));
+        lines.clear();
+        for (; k < indices.size() && shapes.styleAt(indices[k]) == style; ++k) {
+            drawShape(painter, shapes, indices[k], lod, scale, lines, stroke);
+        }
+        if (!lines.isEmpty()) {
+            painter.drawLines(lines.constData(), lines.size());
+        }
+    }
+}
+
+void SceneRenderer::drawShapes(QPainter& painter, const ShapeStore& shapes, const QRect& area, PolylineLod* lod) {
+    QVector<int> indices;
+    for (int i = 0; i < shapes.size(); ++i) {
+        if (shapes.boundsAt(i).intersects(area)) {
+            indices.append(i);
+        }
+    }
+    drawShapes(painter, shapes, indices, lod);
+}
+
+void SceneRenderer::drawLayer(QPainter& painter, qreal opacity, const QRect& deviceRect,
+    const std::function<void(QPainter&)>& draw) {
+    if (opacity >= 1.0) {
+        draw(painter);
+        return;
+    }
+    if (opacity <= 0.0 || deviceRect.isEmpty()) {
+        return;
+    }
+    QImage layer(deviceRect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (layer.isNull()) {
+        return;
+    }
+    layer.fill(Qt::transparent);
+    QPainter layerPainter(&layer);
+    layerPainter.setRenderHints(painter.renderHints());
+    layerPainter.setTransform(painter.transform() * QTransform::fromTranslate(-deviceRect.x(), -deviceRect.y()));
+    draw(layerPainter);
+    layerPainter.end();
+
+    painter.save();
+    painter.resetTransform();
+    painter.setOpacity(painter.opacity() * opacity);
+    painter.drawImage(deviceRect.topLeft(), layer);
+    painter.restore();
+}
+
+QImage SceneRenderer::renderImage(const SceneSnapshot& snapshot, qreal scale) {
+    const QSize outputSize(qRound(snapshot.size.width() * scale), qRound(snapshot.size.height() * scale));
+    if (outputSize.isEmpty()) {
+        return QImage();
+    }
+
+    QImage target(outputSize, QImage::Format_ARGB32_Premultiplied);
+    if (target.isNull()) {
+        return QImage();
+    }
+    target.fill(Qt::white);
+
+    QPainter painter(&target);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.scale(scale, scale);
+    const QRect area(QPoint(0, 0), snapshot.size);
+    if (snapshot.background) {
+        snapshot.background->draw(painter, area);
+    }
+    for (const SnapshotLayer& layer : snapshot.layers) {
+        drawLayer(painter, layer.opacity, target.rect(), [&layer, &area](QPainter& layerPainter) {
+            drawShapes(layerPainter, layer.shapes, area.adjusted(-PenWidth, -PenWidth, PenWidth, PenWidth));
+        });
+    }
+    painter.end();
+
+    return target;
+}
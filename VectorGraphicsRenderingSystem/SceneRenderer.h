@@ -0,0 +1,57 @@
+#ifndef SCENERENDERER_H
+#define SCENERENDERER_H
+
+#include <QPainter>
+#include <QImage>
+#include <QSize>
+#include <QSharedPointer>
+#include <functional>
+#include "ShapeStore.h"
+#include "TiledImage.h"
+
+class PolylineLod;
+
+//еһͼ
+struct SnapshotLayer {
+    ShapeStore shapes;
+    qreal opacity = 1.0;
+};
+
+//գͼβֿⰴֵʽɽֻ߳ʹãͼƬ뻭ͬһݷֿ黺
+struct SceneSnapshot {
+    QVector<SnapshotLayer> layers;//¶ϣֻɼͼ
+    QSharedPointer<TiledImage> background;
+    QSize size;
+};
+
+//봰޹صͼλ߼ȹ
+class SceneRenderer {
+public:
+    static const int PenWidth = 2;
+
+    //˳ indicesеͼΣʽͬͼΪһ飬ÿֻһλʣ߶κϲΪһ drawLines
+    //ɫ뻭ͬȺӰʾͬʽͼ԰±
+    //ṩ lod ʱ߰ʵ豸ѡü򻯶
+    static void drawShapes(QPainter& painter, const ShapeStore& shapes, const QVector<int>& indices, PolylineLod* lod = nullptr);
+    //ưΧ area ཻͼ
+    static void drawShapes(QPainter& painter, const ShapeStore& shapes, const QRect& area, PolylineLod* lod = nullptr);
+
+    //ͬеһͼΣã߶׷ӵ lines Уɵʱһύͼֱӻ
+    static void drawShape(QPainter& painter, const ShapeStore& shapes, int index, PolylineLod* lod, qreal scale,
+        QVector<QLine>& lines, QVector<QPoint>& scratch);
+    static void drawPolyline(QPainter& painter, const ShapeStore& shapes, int index, PolylineLod* lod, qreal scale);
+    //ʼ scratch ƣƶʼʱͬһ scratch
+    static void drawStroke(QPainter& painter, const ShapeStore& shapes, int index, QVector<QPoint>& scratch);
+    //߼굽豸صţ豸ر任
+    static qreal deviceScale(const QPainter& painter);
+
+    // opacity һͼ㣺͸ʱֱӻƣȻ deviceRect豸꣩͸ͼϣ
+    //ͬһͼ໥ǵͼβ͸
+    static void drawLayer(QPainter& painter, qreal opacity, const QRect& deviceRect,
+        const std::function<void(QPainter&)>& draw);
+
+    //ڵǰ߳аհȾΪͼʺϴСͼȾ
+    static QImage renderImage(const SceneSnapshot& snapshot, qreal scale);
+};
+
+#endif // SCENERENDERER_H
@@ -0,0 +1,122 @@
+#include "SceneStatistics.h"
+#include <algorithm>
+#include <iterator>
+
+void SceneStatistics::clear() {
+    perStyle.clear();
+    std::fill(std::begin(typeCounts), std::end(typeCounts), 0);
+    total = 0;
+    length = 0.0;
+    area = 0.0;
+    lefts.clear();
+    tops.clear();
+    rights.clear();
+    bottoms.clear();
+}
+
+void SceneStatistics::rebuild(const ShapeStore& shapes) {
+    clear();
+    for (int i = 0; i < shapes.size(); ++i) {
+        add(shapes, i);
+    }
+}
+
+SceneStatistics::StyleTotals& SceneStatistics::totalsFor(int style) {
+    if (style >= perStyle.size()) {
+        perStyle.resize(style + 1);
+    }
+    return perStyle[style];
+}
+
+const SceneStatistics::StyleTotals& SceneStatistics::style(int style) const {
+    static const StyleTotals empty;
+    return style >= 0 && style < perStyle.size() ? perStyle[style] : empty;
+}
+
+//sign Ϊ 1 ʱ룬Ϊ -1 ʱ۳ʱѶӦۼӺ㣬ⷴӼ
+void SceneStatistics::account(int style, ShapeStore::ShapeType type, qreal metric, int sign) {
+    StyleTotals& totals = totalsFor(style);
+    totals.shapes += sign;
+    typeCounts[type] += sign;
+    total += sign;
+    if (type == ShapeStore::EllipseType) {
+        totals.area += sign * metric;
+        area += sign * metric;
+    }
+    else {
+        totals.length += sign * metric;
+        length += sign * metric;
+    }
+
+    if (totals.shapes == 0) {
+        totals = StyleTotals();
+    }
+    if (typeCounts[ShapeStore::EllipseType] == 0) {
+        area = 0.0;
+    }
+    if (typeCounts[ShapeStore::LineType] + typeCounts[ShapeStore::PolylineType] + typeCounts[ShapeStore::StrokeType] == 0) {
+        length = 0.0;
+    }
+}
+
+static void countEdge(QMap<int, int>& edges, int coordinate, int sign) {
+    auto it = edges.find(coordinate);
+    if (it == edges.end()) {
+        edges.insert(coordinate, sign);
+    }
+    else if ((it.value() += sign) == 0) {
+        edges.erase(it);
+    }
+}
+
+//վ QRect::operator| һΧ
+void SceneStatistics::addEdges(const QRect& shapeBounds) {
+    if (shapeBounds.isNull()) {
+        return;
+    }
+    countEdge(lefts, shapeBounds.left(), 1);
+    countEdge(tops, shapeBounds.top(), 1);
+    countEdge(rights, shapeBounds.right(), 1);
+    countEdge(bottoms, shapeBounds.bottom(), 1);
+}
+
+void SceneStatistics::removeEdges(const QRect& shapeBounds) {
+    if (shapeBounds.isNull()) {
+        return;
+    }
+    countEdge(lefts, shapeBounds.left(), -1);
+    countEdge(tops, shapeBounds.top(), -1);
+    countEdge(rights, shapeBounds.right(), -1);
+    countEdge(bottoms, shapeBounds.bottom(), -1);
+}
+
+void SceneStatistics::add(const ShapeStore& shapes, int index) {
+    account(shapes.styleAt(index), shapes.typeAt(index), shapes.metricAt(index), 1);
+    addEdges(shapes.boundsAt(index));
+}
+
+void SceneStatistics::remove(const ShapeStore& shapes, int index) {
+    account(shapes.styleAt(index), shapes.typeAt(index), shapes.metricAt(index), -1);
+    removeEdges(shapes.boundsAt(index));
+}
+
+void SceneStatistics::move(const QRect& oldBounds, const QRect& newBounds) {
+    removeEdges(oldBounds);
+    addEdges(newBounds);
+}
+
+void SceneStatistics::restyle(const ShapeStore& shapes, int index, int oldStyle) {
+    const int newStyle = shapes.styleAt(index);
+    if (oldStyle == newStyle) {
+        return;
+    }
+    account(oldStyle, shapes.typeAt(index), shapes.metricAt(index), -1);
+    account(newStyle, shapes.typeAt(index), shapes.metricAt(index), 1);
+}
+
+QRect SceneStatistics::bounds() const {
+    if (lefts.isEmpty()) {
+        return QRect();
+    }
+    return QRect(QPoint(lefts.firstKey(), tops.firstKey()), QPoint(rights.lastKey(), bottoms.lastKey()));
+}
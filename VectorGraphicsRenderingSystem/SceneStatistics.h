@@ -0,0 +1,62 @@
+#ifndef SCENESTATISTICS_H
+#define SCENESTATISTICS_H
+
+#include <QVector>
+#include <QMap>
+#include <QRect>
+#include "ShapeStore.h"
+
+//Ļݣɫ߳߶ΡʼԲͼͼΧ
+//ͼεӡɾƽơɫ£ɨУѯΪ O(1)
+//Χе߸һ¼ͼαԵĳִɾΪ O(log k)k Ϊͬĸ
+//ѯֻȡĩԵϵͼα߻ɾҲҪɨͼ
+class SceneStatistics {
+public:
+    struct StyleTotals {
+        qreal length = 0.0;
+        qreal area = 0.0;
+        int shapes = 0;
+    };
+
+    void clear();
+    void rebuild(const ShapeStore& shapes);
+
+    //add ͼμֿãremove ͼδӲֿɾǰ
+    void add(const ShapeStore& shapes, int index);
+    void remove(const ShapeStore& shapes, int index);
+    //ƽƲı䳤ֻӰΧ
+    void move(const QRect& oldBounds, const QRect& newBounds);
+    //ɫʽдֿ
+    void restyle(const ShapeStore& shapes, int index, int oldStyle);
+
+    int shapeCount() const { return total; }
+    int count(ShapeStore::ShapeType type) const { return typeCounts[type]; }
+    qreal totalLength() const { return length; }
+    qreal totalArea() const { return area; }
+
+    //ɫ±ѯ± ShapeStore::colors() һ
+    const StyleTotals& style(int style) const;
+    const QVector<StyleTotals>& styles() const { return perStyle; }
+
+    QRect bounds() const;
+
+private:
+    StyleTotals& totalsFor(int style);
+    void account(int style, ShapeStore::ShapeType type, qreal metric, int sign);
+    void addEdges(const QRect& shapeBounds);
+    void removeEdges(const QRect& shapeBounds);
+
+    QVector<StyleTotals> perStyle;
+    int typeCounts[5] = {};
+    int total = 0;
+    qreal length = 0.0;
+    qreal area = 0.0;
+
+    // -> ԸΪӦߵͼ
+    QMap<int, int> lefts;
+    QMap<int, int> tops;
+    QMap<int, int> rights;
+    QMap<int, int> bottoms;
+};
+
+#endif // SCENESTATISTICS_H
@@ -0,0 +1,436 @@
+#include "ShapeStore.h"
+#include "GeometryKernels.h"
+#include <cstring>
+#include <utility>
+
+//޷ LEB128ÿֽ 7 λλʾ滹ֽ
+static void writeVarint(QByteArray& out, quint32 value) {
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// end δ򳬹 5 ֽʱ false
+static bool readVarint(const uchar*& cursor, const uchar* end, quint32& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && cursor < end; shift += 7) {
+        const uchar byte = *cursor++;
+        value |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//зŲֵӳΪ޷ֵСĲֵΪֽ
+static quint32 zigzag(qint32 value) {
+    return (quint32(value) << 1) ^ quint32(value >> 31);
+}
+
+static qint32 unzigzag(quint32 value) {
+    return qint32(value >> 1) ^ -qint32(value & 1);
+}
+
+ShapeStore::ShapeStore() {
+    styleIndex(Qt::black);
+}
+
+//ȫͼΣɫ屣
+void ShapeStore::clear() {
+    types.clear();
+    bounds.clear();
+    styles.clear();
+    offsets.clear();
+    counts.clear();
+    metrics.clear();
+    ids.clear();
+    streamOffsets.clear();
+    indexById.clear();
+    points.clear();
+    strokeBytes.clear();
+}
+
+void ShapeStore::reserve(int shapeCount, int pointCount) {
+    types.reserve(shapeCount);
+    bounds.reserve(shapeCount);
+    styles.reserve(shapeCount);
+    offsets.reserve(shapeCount);
+    counts.reserve(shapeCount);
+    metrics.reserve(shapeCount);
+    ids.reserve(shapeCount);
+    streamOffsets.reserve(shapeCount);
+    indexById.reserve(shapeCount);
+    points.reserve(pointCount);
+}
+
+//ɫڵɫе±꣬׷
+int ShapeStore::styleIndex(const QColor& color) {
+    const QRgb key = color.rgba();
+    auto it = paletteLookup.constFind(key);
+    if (it != paletteLookup.constEnd()) {
+        return it.value();
+    }
+    int index = palette.size();
+    palette.append(color);
+    paletteLookup.insert(key, index);
+    return index;
+}
+
+int ShapeStore::findStyle(const QColor& color) const {
+    return paletteLookup.value(color.rgba(), -1);
+}
+
+int ShapeStore::claimId(int id, int index) {
+    if (id < 0 || (id < indexById.size() && indexById[id] >= 0)) {
+        id = indexById.size();
+    }
+    while (indexById.size() <= id) {
+        indexById.append(-1);
+    }
+    indexById[id] = index;
+    return id;
+}
+
+int ShapeStore::append(ShapeType type, const QRect& box, const QColor& color, const QPoint* first, int count, qreal metric, int id) {
+    id = claimId(id, types.size());
+
+    types.append(type);
+    bounds.append(box);
+    styles.append(styleIndex(color));
+    offsets.append(points.size());
+    counts.append(count);
+    metrics.append(metric);
+    ids.append(id);
+    streamOffsets.append(-1);
+
+    for (int i = 0; i < count; ++i) {
+        points.append(first[i]);
+    }
+    return id;
+}
+
+QRect ShapeStore::spanBounds(const QPoint& a, const QPoint& b) {
+    return QRect(QPoint(qMin(a.x(), b.x()), qMin(a.y(), b.y())), QPoint(qMax(a.x(), b.x()), qMax(a.y(), b.y())));
+}
+
+int ShapeStore::addLine(const QLine& line, const QColor& color, qreal length, int id) {
+    const QPoint ends[2] = { line.p1(), line.p2() };
+    return append(LineType, spanBounds(ends[0], ends[1]), color, ends, 2, length, id);
+}
+
+int ShapeStore::addPolyline(const QPoint* first, int count, const QColor& color, qreal length, int id) {
+    QRect box;
+    if (count > 0) {
+        int left = first[0].x(), right = left;
+        int top = first[0].y(), bottom = top;
+        for (int i = 1; i < count; ++i) {
+            left = qMin(left, first[i].x());
+            right = qMax(right, first[i].x());
+            top = qMin(top, first[i].y());
+            bottom = qMax(bottom, first[i].y());
+        }
+        box = QRect(QPoint(left, top), QPoint(right, bottom));
+    }
+    return append(PolylineType, box, color, first, count, length, id);
+}
+
+//ԲӾεǵ洢ԭʼܷģ
+int ShapeStore::addEllipse(const QRect& rect, const QColor& color, qreal area, int id) {
+    const QPoint corners[2] = { rect.topLeft(), rect.bottomRight() };
+    return append(EllipseType, spanBounds(corners[0], corners[1]), color, corners, 2, area, id);
+}
+
+//׵֮ĶǸǰһ xy ֵ
+int ShapeStore::addStroke(const QPoint* first, int count, const QColor& color, qreal length, int id) {
+    if (count <= 0) {
+        return -1;
+    }
+    int left = first[0].x(), right = left;
+    int top = first[0].y(), bottom = top;
+    for (int i = 1; i < count; ++i) {
+        left = qMin(left, first[i].x());
+        right = qMax(right, first[i].x());
+        top = qMin(top, first[i].y());
+        bottom = qMax(bottom, first[i].y());
+    }
+    const QRect box(QPoint(left, top), QPoint(right, bottom));
+
+    id = append(StrokeType, box, color, first, 1, length, id);
+    streamOffsets.last() = strokeBytes.size();
+    writeVarint(strokeBytes, quint32(count - 1));
+    for (int i = 1; i < count; ++i) {
+        writeVarint(strokeBytes, zigzag(first[i].x() - first[i - 1].x()));
+        writeVarint(strokeBytes, zigzag(first[i].y() - first[i - 1].y()));
+    }
+    return id;
+}
+
+int ShapeStore::strokePointCountAt(int index) const {
+    const uchar* cursor = reinterpret_cast<const uchar*>(strokeBytes.constData()) + streamOffsets[index];
+    const uchar* end = reinterpret_cast<const uchar*>(strokeBytes.constData()) + strokeBytes.size();
+    quint32 extra = 0;
+    readVarint(cursor, end, extra);
+    return int(extra) + 1;
+}
+
+void ShapeStore::decodeStroke(int index, QVector<QPoint>& out) const {
+    const uchar* cursor = reinterpret_cast<const uchar*>(strokeBytes.constData()) + streamOffsets[index];
+    const uchar* end = reinterpret_cast<const uchar*>(strokeBytes.constData()) + strokeBytes.size();
+    quint32 extra = 0;
+    readVarint(cursor, end, extra);
+    out.resize(int(extra) + 1);
+    QPoint* target = out.data();
+    QPoint point = points[offsets[index]];
+    target[0] = point;
+    for (int i = 1; i <= int(extra); ++i) {
+        quint32 dx = 0, dy = 0;
+        readVarint(cursor, end, dx);
+        readVarint(cursor, end, dy);
+        point += QPoint(unzigzag(dx), unzigzag(dy));
+        target[i] = point;
+    }
+}
+
+int ShapeStore::strokeByteSizeAt(int index) const {
+    const int start = streamOffsets[index];
+    const uchar* begin = reinterpret_cast<const uchar*>(strokeBytes.constData());
+    const uchar* cursor = begin + start;
+    const uchar* end = begin + strokeBytes.size();
+    quint32 extra = 0, delta = 0;
+    readVarint(cursor, end, extra);
+    for (quint32 i = 0; i < 2 * extra; ++i) {
+        readVarint(cursor, end, delta);
+    }
+    return int(cursor - begin) - start;
+}
+
+bool ShapeStore::isStrokeValid(int index) const {
+    const int start = streamOffsets[index];
+    if (start < 0 || start >= strokeBytes.size()) {
+        return false;
+    }
+    const uchar* cursor = reinterpret_cast<const uchar*>(strokeBytes.constData()) + start;
+    const uchar* end = reinterpret_cast<const uchar*>(strokeBytes.constData()) + strokeBytes.size();
+    quint32 extra = 0, delta = 0;
+    //ÿռֽ
+    if (!readVarint(cursor, end, extra) || 2 * quint64(extra) > quint64(end - cursor)) {
+        return false;
+    }
+    for (quint32 i = 0; i < 2 * extra; ++i) {
+        if (!readVarint(cursor, end, delta)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShapeStore::removeLast() {
+    if (types.isEmpty()) {
+        return;
+    }
+    const int last = types.size() - 1;
+    points.resize(offsets[last]);
+    if (streamOffsets[last] >= 0) {
+        strokeBytes.truncate(streamOffsets[last]);
+    }
+    indexById[ids[last]] = -1;
+
+    types.removeLast();
+    bounds.removeLast();
+    styles.removeLast();
+    offsets.removeLast();
+    counts.removeLast();
+    metrics.removeLast();
+    ids.removeLast();
+    streamOffsets.removeLast();
+}
+
+void ShapeStore::appendFrom(const ShapeStore& source, int index, int id) {
+    id = claimId(id, types.size());
+
+    types.append(source.types[index]);
+    bounds.append(source.bounds[index]);
+    styles.append(styleIndex(source.colorAt(index)));
+    offsets.append(points.size());
+    counts.append(source.counts[index]);
+    metrics.append(source.metrics[index]);
+    ids.append(id);
+
+    const PointSpan geometry = source.span(index);
+    for (const QPoint& point : geometry) {
+        points.append(point);
+    }
+    if (source.streamOffsets[index] >= 0) {
+        streamOffsets.append(strokeBytes.size());
+        strokeBytes.append(source.strokeBytes.constData() + source.streamOffsets[index], source.strokeByteSizeAt(index));
+    }
+    else {
+        streamOffsets.append(-1);
+    }
+}
+
+//ͼǰƵдλãʼǰƣдλòȡλãԭؽ
+void ShapeStore::remove(const QVector<int>& indices) {
+    if (indices.isEmpty()) {
+        return;
+    }
+    const int n = types.size();
+    int next = 0;
+    int write = indices[0];
+    int pointWrite = offsets[write];
+    //ʼ밴ͼ˳Уһɾͼ֮ʼдλ
+    int byteWrite = strokeBytes.size();
+    for (int i = write; i < n; ++i) {
+        if (streamOffsets[i] >= 0) {
+            byteWrite = streamOffsets[i];
+            break;
+        }
+    }
+    for (int read = indices[0]; read < n; ++read) {
+        const int count = counts[read];
+        const int offset = offsets[read];
+        const int stream = streamOffsets[read];
+        const int streamSize = stream >= 0 ? strokeByteSizeAt(read) : 0;
+        if (next < indices.size() && indices[next] == read) {
+            ++next;
+            indexById[ids[read]] = -1;
+            continue;
+        }
+        if (write != read) {
+            types[write] = types[read];
+            bounds[write] = bounds[read];
+            styles[write] = styles[read];
+            counts[write] = count;
+            metrics[write] = metrics[read];
+            ids[write] = ids[read];
+            indexById[ids[write]] = write;
+            if (pointWrite != offset && count > 0) {
+                std::memmove(points.data() + pointWrite, points.constData() + offset, count * sizeof(QPoint));
+            }
+            if (stream >= 0 && byteWrite != stream) {
+                std::memmove(strokeBytes.data() + byteWrite, strokeBytes.constData() + stream, streamSize);
+            }
+        }
+        offsets[write] = pointWrite;
+        streamOffsets[write] = stream >= 0 ? byteWrite : -1;
+        pointWrite += count;
+        byteWrite += streamSize;
+        ++write;
+    }
+
+    types.resize(write);
+    bounds.resize(write);
+    styles.resize(write);
+    offsets.resize(write);
+    counts.resize(write);
+    metrics.resize(write);
+    ids.resize(write);
+    streamOffsets.resize(write);
+    points.resize(pointWrite);
+    strokeBytes.resize(byteWrite);
+}
+
+ShapeStore ShapeStore::extract(const QVector<int>& indices) const {
+    ShapeStore result;
+    int pointCount = 0;
+    for (int index : indices) {
+        pointCount += counts[index];
+    }
+    result.reserve(indices.size(), pointCount);
+    for (int k = 0; k < indices.size(); ++k) {
+        result.appendFrom(*this, indices[k], k);
+    }
+    return result;
+}
+
+//˳ֿͼν渴Ƶ²ֿ⣬ɫõǰֿ
+void ShapeStore::reinsert(const ShapeStore& removed, const QVector<int>& removedIds, const QVector<int>& positions) {
+    ShapeStore merged;
+    merged.palette = palette;
+    merged.paletteLookup = paletteLookup;
+    merged.reserve(size() + removed.size(), points.size() + removed.points.size());
+    merged.indexById.fill(-1, indexById.size());
+
+    const int total = size() + removed.size();
+    int read = 0;
+    int k = 0;
+    for (int position = 0; position < total; ++position) {
+        if (k < positions.size() && positions[k] == position) {
+            merged.appendFrom(removed, k, removedIds[k]);
+            ++k;
+        }
+        else {
+            merged.appendFrom(*this, read, ids[read]);
+            ++read;
+        }
+    }
+    *this = std::move(merged);
+}
+
+qint64 ShapeStore::byteSize() const {
+    const qint64 perShape = sizeof(quint8) + sizeof(QRect) + 5 * sizeof(int) + sizeof(qreal) + sizeof(int);
+    return qint64(types.size()) * perShape + qint64(points.size()) * sizeof(QPoint)
+        + strokeBytes.size() + qint64(palette.size()) * sizeof(QColor);
+}
+
+QLine ShapeStore::lineAt(int index) const {
+    const QPoint* p = pointsAt(index);
+    return QLine(p[0], p[1]);
+}
+
+QRect ShapeStore::ellipseAt(int index) const {
+    const QPoint* p = pointsAt(index);
+    return QRect(p[0], p[1]);
+}
+
+//ƽƣԭƽƣΧͬƽ
+void ShapeStore::translate(int index, const QPoint& offset) {
+    GeometryKernels::translatePoints(points.data() + offsets[index], counts[index], offset);
+    bounds[index].translate(offset);
+}
+
+void ShapeStore::translate(const QVector<int>& indices, const QPoint& offset) {
+    QPoint* data = points.data();
+    int spanStart = 0;
+    int spanEnd = 0;
+    for (int index : indices) {
+        bounds[index].translate(offset);
+        const int start = offsets[index];
+        if (start != spanEnd) {
+            GeometryKernels::translatePoints(data + spanStart, spanEnd - spanStart, offset);
+            spanStart = start;
+        }
+        spanEnd = start + counts[index];
+    }
+    GeometryKernels::translatePoints(data + spanStart, spanEnd - spanStart, offset);
+}
+
+void ShapeStore::setStyle(const QVector<int>& indices, int style) {
+    for (int index : indices) {
+        styles[index] = style;
+    }
+}
+
+void ShapeStore::setColor(int index, const QColor& color) {
+    styles[index] = styleIndex(color);
+}
+
+void ShapeStore::resetIds() {
+    const int count = types.size();
+    ids.resize(count);
+    indexById.resize(count);
+    for (int i = 0; i < count; ++i) {
+        ids[i] = i;
+        indexById[i] = i;
+    }
+}
+
+void ShapeStore::rebuildPaletteLookup() {
+    paletteLookup.clear();
+    for (int i = 0; i < palette.size(); ++i) {
+        paletteLookup.insert(palette[i].rgba(), i);
+    }
+}
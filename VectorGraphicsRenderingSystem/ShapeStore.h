@@ -0,0 +1,145 @@
+#ifndef SHAPESTORE_H
+#define SHAPESTORE_H
+
+#include <QVector>
+#include <QHash>
+#include <QPoint>
+#include <QLine>
+#include <QRect>
+#include <QPolygon>
+#include <QColor>
+#include <QByteArray>
+#include <QMetaType>
+
+//ֻͼָֿ points еһΣӵݣֿⱻ޸ĺʧЧ
+struct PointSpan {
+    const QPoint* first = nullptr;
+    int count = 0;
+
+    const QPoint* begin() const { return first; }
+    const QPoint* end() const { return first + count; }
+    const QPoint* data() const { return first; }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    const QPoint& operator[](int i) const { return first[i]; }
+};
+
+//ͼβֿ⣺ͼΰ
+// i ͼε͡ΧСʽƫֱλڸеĵ i 
+//ζͳһ points У (offset, count) ʣʼ붼ͼ˳У
+//ɾʱͼǰѹնֿ԰ֱдӳ
+//ֻʼֻ points д׵㣨ƽʱһƶǰһĲֵ
+// zigzagvarint ׷ӵ strokeBytes Увʱ
+class ShapeStore {
+public:
+    enum ShapeType : quint8 {
+        NoneType,
+        LineType,
+        PolylineType,
+        EllipseType,
+        StrokeType
+    };
+
+    ShapeStore();
+
+    void clear();
+    void reserve(int shapeCount, int pointCount);
+
+    //ͼΣȶͼIDID ֻɾ󲻻ͼ
+    //id ΪͷŵIDʱøIDӡɾID
+    int addLine(const QLine& line, const QColor& color, qreal length, int id = -1);
+    int addPolyline(const QPoint* first, int count, const QColor& color, qreal length, int id = -1);
+    int addEllipse(const QRect& rect, const QColor& color, qreal area, int id = -1);
+    int addStroke(const QPoint* first, int count, const QColor& color, qreal length, int id = -1);
+
+    //ɾһͼΣӣIDʱԭID
+    void removeLast();
+    //ɾһͼΣindices 򣩣һαѹСʼ룻ɾͼεID reinsert ָ
+    void remove(const QVector<int>& indices);
+    //һͼΣindices 򣩵²ֿ⣬˳򲻱
+    ShapeStore extract(const QVector<int>& indices) const;
+    // extract õͼԭIDŻأ k ͼηŻغλ positions[k]򣩣ͼ˳򲻱
+    void reinsert(const ShapeStore& removed, const QVector<int>& removedIds, const QVector<int>& positions);
+
+    void translate(int index, const QPoint& offset);
+    void setColor(int index, const QColor& color);
+    void setStyle(int index, int style) { styles[index] = style; }
+
+    //ƽơʽindices 밴УڵͼκϲΪһƽ
+    void translate(const QVector<int>& indices, const QPoint& offset);
+    void setStyle(const QVector<int>& indices, int style);
+
+    int size() const { return types.size(); }
+    bool isEmpty() const { return types.isEmpty(); }
+    qint64 byteSize() const;//붥Ľڴռ
+
+    //ID ±ĻתID ʱ -1
+    int indexOf(int id) const { return id >= 0 && id < indexById.size() ? indexById[id] : -1; }
+    int idAt(int index) const { return ids[index]; }
+
+    ShapeType typeAt(int index) const { return ShapeType(types[index]); }
+    const QRect& boundsAt(int index) const { return bounds[index]; }
+    int styleAt(int index) const { return styles[index]; }
+    qreal metricAt(int index) const { return metrics[index]; }
+    const QColor& colorAt(int index) const { return palette[styles[index]]; }
+
+    //η
+    const QPoint* pointsAt(int index) const { return points.constData() + offsets[index]; }
+    int pointCountAt(int index) const { return counts[index]; }
+    PointSpan span(int index) const { return PointSpan{ pointsAt(index), counts[index] }; }
+    QLine lineAt(int index) const;
+    QRect ellipseAt(int index) const;
+    //ʼĶout ԭݱ
+    int strokePointCountAt(int index) const;
+    void decodeStroke(int index, QVector<QPoint>& out) const;
+    int strokeByteSizeAt(int index) const;
+
+    //еֻʣںֱӱ
+    const QPoint* pointColumn() const { return points.constData(); }
+    const int* offsetColumn() const { return offsets.constData(); }
+    const int* countColumn() const { return counts.constData(); }
+
+    const QVector<QColor>& colors() const { return palette; }
+
+    // ab ΪԽǣأİΧУ 1x1QRect(a, b).normalized()  b.x() == a.x() - 1 ʱΪ 0
+    //κ򶼲ཻü©ͼ
+    static QRect spanBounds(const QPoint& a, const QPoint& b);
+    int styleIndex(const QColor& color);
+    int findStyle(const QColor& color) const;//ڵɫʱ -1
+
+private:
+    friend class SceneFile; //ļд
+
+    int append(ShapeType type, const QRect& box, const QColor& color, const QPoint* first, int count, qreal metric, int id);
+    //ǼͼIDid ΪͷŵIDʱãID
+    int claimId(int id, int index);
+    //ָID׷һֿеͼΣʼԭ
+    void appendFrom(const ShapeStore& source, int index, int id);
+
+    //ÿͼһ
+    QVector<quint8> types;
+    QVector<QRect> bounds;
+    QVector<int> styles;
+    QVector<int> offsets;
+    QVector<int> counts;
+    QVector<qreal> metrics;
+    QVector<int> ids;
+    QVector<int> streamOffsets;//ʼ strokeBytes еʼλãͼΪ -1
+
+    QVector<int> indexById; //ID -> ±
+    QVector<QPoint> points; //ͼεĶ
+    QByteArray strokeBytes; //бʼĲֵ
+
+    QVector<QColor> palette;
+    QHash<QRgb, int> paletteLookup;
+
+    //кؽ ID ӳɫұ
+    void resetIds();
+    void rebuildPaletteLookup();
+    //ʼҲԽ磬ļʱУ
+    bool isStrokeValid(int index) const;
+};
+
+Q_DECLARE_METATYPE(ShapeStore)
+
+#endif // SHAPESTORE_H
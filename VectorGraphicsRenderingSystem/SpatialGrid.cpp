@@ -0,0 +1,110 @@
+#include "SpatialGrid.h"
+#include "ShapeStore.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(int cellSize)
+    : cellSize(cellSize) {
+}
+
+void SpatialGrid::clear() {
+    cells.clear();
+    oversized.clear();
+}
+
+//ͼβֿؽ
+void SpatialGrid::build(const ShapeStore& shapes) {
+    clear();
+    for (int i = 0; i < shapes.size(); ++i) {
+        insert(shapes.idAt(i), shapes.boundsAt(i));
+    }
+}
+
+quint64 SpatialGrid::cellKey(int cx, int cy) {
+    return (quint64(quint32(cx)) << 32) | quint32(cy);
+}
+
+//ȡ꣬ͬ
+int SpatialGrid::cellCoord(int v) const {
+    return v >= 0 ? v / cellSize : -((-v - 1) / cellSize) - 1;
+}
+
+//ΧиǵΧǹʱ false
+bool SpatialGrid::cellRange(const QRect& bounds, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = cellCoord(bounds.left());
+    y0 = cellCoord(bounds.top());
+    x1 = cellCoord(bounds.right());
+    y1 = cellCoord(bounds.bottom());
+    return qint64(x1 - x0 + 1) * (y1 - y0 + 1) <= MaxCellsPerShape;
+}
+
+void SpatialGrid::insert(int id, const QRect& bounds) {
+    int x0, y0, x1, y1;
+    if (!cellRange(bounds, x0, y0, x1, y1)) {
+        oversized.append(id);
+        return;
+    }
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            cells[cellKey(cx, cy)].append(id);
+        }
+    }
+}
+
+void SpatialGrid::remove(int id, const QRect& bounds) {
+    int x0, y0, x1, y1;
+    if (!cellRange(bounds, x0, y0, x1, y1)) {
+        oversized.removeOne(id);
+        return;
+    }
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            auto it = cells.find(cellKey(cx, cy));
+            if (it == cells.end()) {
+                continue;
+            }
+            it.value().removeOne(id);
+            if (it.value().isEmpty()) {
+                cells.erase(it);
+            }
+        }
+    }
+}
+
+void SpatialGrid::move(int id, const QRect& oldBounds, const QRect& newBounds) {
+    remove(id, oldBounds);
+    insert(id, newBounds);
+}
+
+void SpatialGrid::query(const QRect& area, QVector<int>& candidates) const {
+    candidates += oversized;
+
+    int x0, y0, x1, y1;
+    cellRange(area, x0, y0, x1, y1);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            auto it = cells.constFind(cellKey(cx, cy));
+            if (it != cells.constEnd()) {
+                candidates += it.value();
+            }
+        }
+    }
+}
+
+qint64 SpatialGrid::cellCount(const QRect& area) const {
+    int x0, y0, x1, y1;
+    cellRange(area, x0, y0, x1, y1);
+    return qint64(x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+void SpatialGrid::collect(const ShapeStore& shapes, const QRect& area, QVector<int>& indices) const {
+    indices.clear();
+    query(area, indices);
+    for (int& index : indices) {
+        index = shapes.indexOf(index);
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    indices.erase(std::remove_if(indices.begin(), indices.end(), [&](int index) {
+        return index < 0 || !shapes.boundsAt(index).intersects(area);
+    }), indices.end());
+}
@@ -0,0 +1,42 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <QHash>
+#include <QVector>
+#include <QRect>
+
+class ShapeStore;
+
+//ռΧаͼIDǼǵ串ǵĸԪ
+//ǵԪĴͼεţÿβѯΪѡ
+class SpatialGrid {
+public:
+    explicit SpatialGrid(int cellSize = 64);
+
+    void clear();
+    void build(const ShapeStore& shapes);
+
+    void insert(int id, const QRect& bounds);
+    void remove(int id, const QRect& bounds);
+    void move(int id, const QRect& oldBounds, const QRect& newBounds);
+
+    //ɸذΧп area ཻͼIDظ
+    void query(const QRect& area, QVector<int>& candidates) const;
+    //ɸתΪ±ꡢȥأ޳ΧвཻͼΣ˳
+    void collect(const ShapeStore& shapes, const QRect& area, QVector<int>& indices) const;
+    //ѯ area ҪʵԪѯ˳ɨ֮ȡ
+    qint64 cellCount(const QRect& area) const;
+
+private:
+    static quint64 cellKey(int cx, int cy);
+    bool cellRange(const QRect& bounds, int& x0, int& y0, int& x1, int& y1) const;
+    int cellCoord(int v) const;
+
+    int cellSize;
+    QHash<quint64, QVector<int>> cells;
+    QVector<int> oversized;
+
+    static const int MaxCellsPerShape = 256;
+};
+
+#endif // SPATIALGRID_H
@@ -0,0 +1,77 @@
+#include "StrokeSimplifier.h"
+
+//㵽߶εľƽ
+static qreal segmentDistanceSquared(const QPoint& p, const QPoint& a, const QPoint& b) {
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    qreal px = p.x() - a.x();
+    qreal py = p.y() - a.y();
+    const qreal lengthSquared = dx * dx + dy * dy;
+    if (lengthSquared > 0.0) {
+        const qreal t = qBound<qreal>(0.0, (px * dx + py * dy) / lengthSquared, 1.0);
+        px -= t * dx;
+        py -= t * dy;
+    }
+    return px * px + py * py;
+}
+
+static qreal distanceSquared(const QPoint& a, const QPoint& b) {
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    return dx * dx + dy * dy;
+}
+
+void StrokeSimplifier::begin(const QPoint& point, qreal tolerance) {
+    clear();
+    toleranceSquared = tolerance * tolerance;
+    kept.append(point);
+    box = QRect(point, QSize(1, 1));
+}
+
+void StrokeSimplifier::clear() {
+    kept.clear();
+    run.clear();
+    box = QRect();
+}
+
+QRect StrokeSimplifier::add(const QPoint& point) {
+    if (kept.isEmpty()) {
+        return QRect();
+    }
+    const QPoint anchor = kept.last();
+    const QPoint previous = tail();
+    if (distanceSquared(previous, point) < toleranceSquared) {
+        return QRect();
+    }
+
+    //㵽²߶βܴڵĲʱһΪµı
+    bool fits = run.size() < MaxRun;
+    for (int i = 0; fits && i < run.size(); ++i) {
+        fits = segmentDistanceSquared(run[i], anchor, point) <= toleranceSquared;
+    }
+    if (!fits) {
+        kept.append(previous);
+        run.clear();
+    }
+    run.append(point);
+    box |= QRect(point, QSize(1, 1));
+
+    //仯ֻб㡢ԭʼ²֮߶
+    const int left = qMin(anchor.x(), qMin(previous.x(), point.x()));
+    const int top = qMin(anchor.y(), qMin(previous.y(), point.y()));
+    const int right = qMax(anchor.x(), qMax(previous.x(), point.x()));
+    const int bottom = qMax(anchor.y(), qMax(previous.y(), point.y()));
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+QVector<QPoint> StrokeSimplifier::finish() {
+    QVector<QPoint> result;
+    if (!kept.isEmpty()) {
+        result = kept;
+        if (!run.isEmpty()) {
+            result.append(run.last());
+        }
+    }
+    clear();
+    return result;
+}
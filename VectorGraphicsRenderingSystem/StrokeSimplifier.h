@@ -0,0 +1,36 @@
+#ifndef STROKESIMPLIFIER_H
+#define STROKESIMPLIFIER_H
+
+#include <QVector>
+#include <QPoint>
+#include <QRect>
+
+//ֻʼ߼򻯣ʱԭʼ
+//һСݲĵֱӶݴһһУ
+//ֻҪӱ㵽²߶вľ붼ݲͼӳ
+//һΪµı㡣γޣÿĴʱΪ
+class StrokeSimplifier {
+public:
+    static const int MaxRun = 128;
+
+    void begin(const QPoint& point, qreal tolerance);
+    //һԤз仯ķΧʱؿվ
+    QRect add(const QPoint& point);
+    //ʼرĶ㣨һ״̬
+    QVector<QPoint> finish();
+    void clear();
+
+    bool isEmpty() const { return kept.isEmpty(); }
+    //ȷĶµĲԤʱ
+    const QVector<QPoint>& points() const { return kept; }
+    QPoint tail() const { return run.isEmpty() ? kept.last() : run.last(); }
+    QRect bounds() const { return box; }
+
+private:
+    qreal toleranceSquared = 1.0;
+    QVector<QPoint> kept;
+    QVector<QPoint> run;//һ֮ĲһΪʼ
+    QRect box;
+};
+
+#endif // STROKESIMPLIFIER_H
@@ -0,0 +1,163 @@
+#include "SvgImporter.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLineF>
+#include <QLocale>
+#include <QRectF>
+#include <QStringView>
+#include <QXmlStreamReader>
+
+static double number(const QXmlStreamAttributes& attrs, const char* name) {
+    return QLocale::c().toDouble(attrs.value(QLatin1String(name)));
+}
+
+//ȡ stroke Ի style е strokeδָʱøԪصɫ
+static QColor strokeOf(const QXmlStreamAttributes& attrs, const QColor& inherited) {
+    QString value = attrs.value(QLatin1String("stroke")).toString();
+    if (value.isEmpty()) {
+        const QString style = attrs.value(QLatin1String("style")).toString();
+        const int at = style.indexOf(QLatin1String("stroke:"));
+        if (at >= 0) {
+            const int start = at + 7;
+            const int end = style.indexOf(QLatin1Char(';'), start);
+            value = style.mid(start, end < 0 ? -1 : end - start).trimmed();
+        }
+    }
+    const QColor color(value);
+    return color.isValid() ? color : inherited;
+}
+
+SvgImporter::SvgImporter(const QString& filePath, int batchSize, QObject* parent)
+    : QObject(parent), filePath(filePath), batchSize(batchSize), inFlight(MaxBatchesInFlight), canceled(false) {
+    qRegisterMetaType<ShapeStore>("ShapeStore");
+}
+
+//̴߳һã̼߳һ
+void SvgImporter::releaseBatch() {
+    inFlight.release();
+}
+
+void SvgImporter::cancel() {
+    canceled = true;
+    inFlight.release(MaxBatchesInFlight);
+}
+
+void SvgImporter::flush(ShapeStore& batch) {
+    if (batch.isEmpty()) {
+        return;
+    }
+    inFlight.acquire();
+    if (canceled) {
+        return;
+    }
+    emit batchReady(batch);
+    batch = ShapeStore();
+    batch.reserve(batchSize, batchSize * 2);
+}
+
+// points ԣ"x1,y1 x2,y2 ..."հ׾Ϊָ
+bool SvgImporter::parsePoints(const QString& text, QVector<QPoint>& points) const {
+    points.clear();
+    const QLocale c = QLocale::c();
+    const QStringView view(text);
+    const int n = text.size();
+    qreal x = 0.0;
+    bool haveX = false;
+    int i = 0;
+    while (i < n) {
+        while (i < n && (text[i].isSpace() || text[i] == QLatin1Char(','))) {
+            ++i;
+        }
+        const int start = i;
+        while (i < n && !text[i].isSpace() && text[i] != QLatin1Char(',')) {
+            ++i;
+        }
+        if (start == i) {
+            break;
+        }
+        bool ok = false;
+        const qreal value = c.toDouble(view.mid(start, i - start), &ok);
+        if (!ok) {
+            return false;
+        }
+        if (haveX) {
+            points.append(QPointF(x, value).toPoint());
+        }
+        else {
+            x = value;
+        }
+        haveX = !haveX;
+    }
+    return true;
+}
+
+void SvgImporter::run() {
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit finished(false, 0, timer.elapsed(), file.errorString());
+        return;
+    }
+
+    QXmlStreamReader reader(&file);
+    QVector<QColor> strokes;//ԪǶʱ̳еɫջ
+    strokes.append(Qt::black);
+    ShapeStore batch;
+    batch.reserve(batchSize, batchSize * 2);
+    QVector<QPoint> points;
+    int total = 0;
+
+    while (!reader.atEnd() && !canceled) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::EndElement) {
+            if (strokes.size() > 1) {
+                strokes.removeLast();
+            }
+            continue;
+        }
+        if (token != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        const QXmlStreamAttributes attrs = reader.attributes();
+        const QColor color = strokeOf(attrs, strokes.last());
+        strokes.append(color);
+
+        const auto name = reader.name();
+        if (name == QLatin1String("line")) {
+            QLineF line(number(attrs, "x1"), number(attrs, "y1"), number(attrs, "x2"), number(attrs, "y2"));
+            batch.addLine(line.toLine(), color, 0.0);
+        }
+        else if (name == QLatin1String("polyline")) {
+            if (!parsePoints(attrs.value(QLatin1String("points")).toString(), points) || points.isEmpty()) {
+                continue;
+            }
+            batch.addPolyline(points.constData(), points.size(), color, 0.0);
+        }
+        else if (name == QLatin1String("ellipse")) {
+            const qreal cx = number(attrs, "cx");
+            const qreal cy = number(attrs, "cy");
+            const qreal rx = number(attrs, "rx");
+            const qreal ry = number(attrs, "ry");
+            batch.addEllipse(QRectF(cx - rx, cy - ry, 2 * rx, 2 * ry).toRect(), color, 0.0);
+        }
+        else {
+            continue;
+        }
+
+        ++total;
+        if (batch.size() >= batchSize) {
+            flush(batch);
+        }
+    }
+
+    if (!canceled) {
+        flush(batch);
+    }
+
+    const bool ok = !canceled && !reader.hasError();
+    const QString error = canceled ? QString("Import canceled.") : reader.errorString();
+    emit finished(ok, total, timer.elapsed(), ok ? QString() : error);
+}
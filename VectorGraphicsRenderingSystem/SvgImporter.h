@@ -0,0 +1,44 @@
+#ifndef SVGIMPORTER_H
+#define SVGIMPORTER_H
+
+#include <QObject>
+#include <QSemaphore>
+#include <QString>
+#include <QVector>
+#include <QColor>
+#include <atomic>
+#include "ShapeStore.h"
+
+//ʽ SVG 룺ڹ߳ QXmlStreamReader ȡ linepolylineellipse
+//ÿ batchSize ͼηһ DOM
+//ͬʱ;ޣ̴߳һ releaseBatch()ڴֻС
+//еĳȡɽշ¼
+class SvgImporter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SvgImporter(const QString& filePath, int batchSize = 4096, QObject* parent = nullptr);
+
+    void releaseBatch();
+    void cancel();
+
+public slots:
+    void run();
+
+signals:
+    void batchReady(const ShapeStore& batch);
+    void finished(bool ok, int shapeCount, qint64 elapsedMs, const QString& error);
+
+private:
+    void flush(ShapeStore& batch);
+    bool parsePoints(const QString& text, QVector<QPoint>& points) const;
+
+    QString filePath;
+    int batchSize;
+    QSemaphore inFlight;
+    std::atomic<bool> canceled;
+
+    static const int MaxBatchesInFlight = 4;
+};
+
+#endif // SVGIMPORTER_H
@@ -0,0 +1,128 @@
+#include "TiledImage.h"
+#include "SceneRenderer.h"
+#include "Profiler.h"
+#include <QImageReader>
+#include <QMutexLocker>
+#include <cmath>
+#include <climits>
+
+//СڸͼƬֱ
+static const qint64 WholeDecodeLimit = 4ll * TiledImage::TileSize * TiledImage::TileSize;
+
+TiledImage::TiledImage(const QString& filePath)
+    : path(filePath) {
+    setCacheLimit(DefaultCacheLimit);
+
+    QImageReader reader(filePath);
+    imageSize = reader.size();
+    regionDecoding = imageSize.isValid()
+        && qint64(imageSize.width()) * imageSize.height() > WholeDecodeLimit
+        && reader.supportsOption(QImageIOHandler::ClipRect);
+    if (!regionDecoding) {
+        source = reader.read();
+        imageSize = source.size();
+    }
+    if (isNull()) {
+        source = QImage();
+        return;
+    }
+
+    //һĵ鸲ͼƬ
+    levels = 1;
+    while ((qMax(imageSize.width(), imageSize.height()) >> (levels - 1)) > TileSize) {
+        ++levels;
+    }
+}
+
+void TiledImage::setCacheLimit(qint64 bytes) {
+    QMutexLocker locker(&mutex);
+    tiles.setMaxCost(int(qMin<qint64>(bytes / 1024, INT_MAX)));
+}
+
+qint64 TiledImage::cachedBytes() const {
+    QMutexLocker locker(&mutex);
+    return qint64(tiles.totalCost()) * 1024;
+}
+
+qint64 TiledImage::cacheHits() const {
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+qint64 TiledImage::cacheMisses() const {
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+int TiledImage::levelFor(qreal scale) const {
+    if (scale <= 0.0 || levels == 0) {
+        return 0;
+    }
+    const int level = int(std::floor(std::log2(1.0 / scale)));
+    return qBound(0, level, levels - 1);
+}
+
+QRect TiledImage::tileArea(int level, int column, int row) const {
+    const int span = TileSize << level;
+    return QRect(column * span, row * span, span, span) & rect();
+}
+
+//벢Сüķֱ
+QImage TiledImage::decode(int level, const QRect& area) const {
+    PROFILE_SCOPE("TiledImage::decode");
+    const QSize scaled(qMax(1, (area.width() + (1 << level) - 1) >> level),
+        qMax(1, (area.height() + (1 << level) - 1) >> level));
+    if (!regionDecoding) {
+        return source.copy(area).scaled(scaled, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    QImageReader reader(path);
+    reader.setClipRect(area);
+    if (level > 0) {
+        reader.setScaledSize(scaled);
+    }
+    return reader.read();
+}
+
+//ȡһ飬ûʱ룬߳̿ͬʱ벻ͬĿ
+QImage TiledImage::tile(int level, int column, int row) {
+    const quint64 key = (quint64(level) << 48) | (quint64(row) << 24) | quint64(column);
+    {
+        QMutexLocker locker(&mutex);
+        if (QImage* cached = tiles.object(key)) {
+            ++hits;
+            return *cached;
+        }
+        ++misses;
+    }
+
+    QImage image = decode(level, tileArea(level, column, row));
+    if (!image.isNull()) {
+        QMutexLocker locker(&mutex);
+        tiles.insert(key, new QImage(image), int(qMax<qint64>(1, image.sizeInBytes() / 1024)));
+    }
+    return image;
+}
+
+void TiledImage::draw(QPainter& painter, const QRect& area) {
+    const QRect visible = area & rect();
+    if (visible.isEmpty()) {
+        return;
+    }
+    const int level = levelFor(SceneRenderer::deviceScale(painter));
+
+    //ͼƬԭʼֱֱӴͼȡ򣬲Ƴɿ
+    if (!regionDecoding && level == 0) {
+        painter.drawImage(visible.topLeft(), source, visible);
+        return;
+    }
+
+    const int span = TileSize << level;
+    for (int row = visible.top() / span; row <= visible.bottom() / span; ++row) {
+        for (int column = visible.left() / span; column <= visible.right() / span; ++column) {
+            const QImage image = tile(level, column, row);
+            if (!image.isNull()) {
+                painter.drawImage(QRectF(tileArea(level, column, row)), image);
+            }
+        }
+    }
+}
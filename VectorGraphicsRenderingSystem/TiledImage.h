@@ -0,0 +1,56 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QRect>
+#include <QCache>
+#include <QMutex>
+#include <QPainter>
+
+//ֿ顢༶ıͼƬʱֻȡļͷʱɼĿ
+// L ÿ鸲 TileSize * 2^L أΪ TileSize ͼСʾʱѡúʵļ
+//ְ֧ĸʽ JPEG QImageReader Ĳüֱӽ룬ʽһκп
+//ѽĿڰֽڼƵ LRU Уڶ߳ͬʱ
+class TiledImage {
+public:
+    static const int TileSize = 512;
+    static const qint64 DefaultCacheLimit = 256ll * 1024 * 1024;
+
+    explicit TiledImage(const QString& filePath);
+
+    bool isNull() const { return imageSize.isEmpty(); }
+    QSize size() const { return imageSize; }
+    QRect rect() const { return QRect(QPoint(0, 0), imageSize); }
+    int levelCount() const { return levels; }
+
+    void setCacheLimit(qint64 bytes);
+    qint64 cachedBytes() const;
+    //黺δдܸʾ
+    qint64 cacheHits() const;
+    qint64 cacheMisses() const;
+
+    // areaཻ꣩Ŀ飬𰴻ʵ豸ѡȡ
+    void draw(QPainter& painter, const QRect& area);
+    //豸Ϊ scale ʱʹõļ𣺲ֱʵϸһ
+    int levelFor(qreal scale) const;
+
+private:
+    QImage tile(int level, int column, int row);
+    QImage decode(int level, const QRect& source) const;
+    QRect tileArea(int level, int column, int row) const;
+
+    QString path;
+    QSize imageSize;
+    int levels = 0;
+    bool regionDecoding = false;
+    QImage source;//ְ֧ʱͼ
+
+    mutable QMutex mutex;
+    QCache<quint64, QImage> tiles;// KiB 
+    qint64 hits = 0;
+    qint64 misses = 0;
+};
+
+#endif // TILEDIMAGE_H
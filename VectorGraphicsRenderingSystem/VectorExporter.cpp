@@ -0,0 +1,301 @@
+#include "VectorExporter.h"
+#include "Profiler.h"
+#include <QSaveFile>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QMarginsF>
+#include <cstring>
+
+namespace {
+
+const int ProgressStep = 16384;//ÿдôͼαһν
+const int LineChunk = 4096;//PDF ÿ drawLines ύ߶
+
+//˳дĻ׷ӵ̶СĻд룬ڴռ볡С޹
+class BufferedWriter {
+public:
+    static const int Capacity = 1 << 16;
+
+    explicit BufferedWriter(QIODevice* device)
+        : device(device), used(0), ok(true) {
+        buffer.resize(Capacity);
+    }
+
+    void put(const char* text, int length) {
+        if (used + length > Capacity) {
+            flush();
+        }
+        if (length > Capacity) {
+            ok = ok && device->write(text, length) == length;
+            return;
+        }
+        std::memcpy(buffer.data() + used, text, length);
+        used += length;
+    }
+
+    void put(const char* text) {
+        put(text, int(std::strlen(text)));
+    }
+
+    void put(const QByteArray& text) {
+        put(text.constData(), text.size());
+    }
+
+    void put(char c) {
+        if (used == Capacity) {
+            flush();
+        }
+        buffer.data()[used++] = c;
+    }
+
+    //ֱתΪʮƣ QString
+    void putInt(qint64 value) {
+        char digits[24];
+        int n = 0;
+        quint64 magnitude = value < 0 ? quint64(0) - quint64(value) : quint64(value);
+        do {
+            digits[n++] = char('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) {
+            digits[n++] = '-';
+        }
+        char text[24];
+        for (int i = 0; i < n; ++i) {
+            text[i] = digits[n - 1 - i];
+        }
+        put(text, n);
+    }
+
+    //д twice / 2ʱ ".5"
+    void putHalf(qint64 twice) {
+        if (twice < 0) {
+            put('-');
+            twice = -twice;
+        }
+        putInt(twice / 2);
+        if (twice & 1) {
+            put(".5", 2);
+        }
+    }
+
+    bool flush() {
+        if (used > 0) {
+            ok = ok && device->write(buffer.constData(), used) == used;
+            used = 0;
+        }
+        return ok;
+    }
+
+private:
+    QIODevice* device;
+    QByteArray buffer;
+    int used;
+    bool ok;
+};
+
+// first ʽͬһͼεĽ±
+int runEnd(const ShapeStore& shapes, int first) {
+    const int style = shapes.styleAt(first);
+    int end = first + 1;
+    while (end < shapes.size() && shapes.styleAt(end) == style) {
+        ++end;
+    }
+    return end;
+}
+
+int shapeCount(const SceneSnapshot& snapshot) {
+    int total = 0;
+    for (const SnapshotLayer& layer : snapshot.layers) {
+        total += layer.shapes.size();
+    }
+    return total;
+}
+
+void writePoints(BufferedWriter& out, const QPoint* points, int count) {
+    out.put("<polyline points=\"");
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            out.put(' ');
+        }
+        out.putInt(points[i].x());
+        out.put(',');
+        out.putInt(points[i].y());
+    }
+    out.put("\"/>\n");
+}
+
+void writeShape(BufferedWriter& out, const ShapeStore& shapes, int index, QVector<QPoint>& stroke) {
+    switch (shapes.typeAt(index)) {
+    case ShapeStore::LineType: {
+        const QLine line = shapes.lineAt(index);
+        out.put("<line x1=\"");
+        out.putInt(line.x1());
+        out.put("\" y1=\"");
+        out.putInt(line.y1());
+        out.put("\" x2=\"");
+        out.putInt(line.x2());
+        out.put("\" y2=\"");
+        out.putInt(line.y2());
+        out.put("\"/>\n");
+        break;
+    }
+    case ShapeStore::PolylineType: {
+        const PointSpan points = shapes.span(index);
+        writePoints(out, points.data(), points.size());
+        break;
+    }
+    case ShapeStore::StrokeType:
+        shapes.decodeStroke(index, stroke);
+        writePoints(out, stroke.constData(), stroke.size());
+        break;
+    case ShapeStore::EllipseType: {
+        //QRect Ŀ߰أ뾶ǰ
+        const QRect rect = shapes.ellipseAt(index).normalized();
+        out.put("<ellipse cx=\"");
+        out.putHalf(2 * qint64(rect.x()) + rect.width());
+        out.put("\" cy=\"");
+        out.putHalf(2 * qint64(rect.y()) + rect.height());
+        out.put("\" rx=\"");
+        out.putHalf(rect.width());
+        out.put("\" ry=\"");
+        out.putHalf(rect.height());
+        out.put("\"/>\n");
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+}
+
+bool VectorExporter::saveSvg(const SceneSnapshot& snapshot, const QString& filePath,
+    const std::function<void(int done, int total)>& progress) {
+    PROFILE_SCOPE("VectorExporter::saveSvg");
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    BufferedWriter out(&file);
+    const int total = shapeCount(snapshot);
+    int done = 0;
+
+    //ɫ뵼 PNG һ£ñӷʽ QPen Ĭֵһ
+    out.put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\"");
+    out.putInt(snapshot.size.width());
+    out.put("\" height=\"");
+    out.putInt(snapshot.size.height());
+    out.put("\" viewBox=\"0 0 ");
+    out.putInt(snapshot.size.width());
+    out.put(' ');
+    out.putInt(snapshot.size.height());
+    out.put("\">\n<rect width=\"100%\" height=\"100%\" fill=\"#ffffff\"/>\n");
+    out.put("<g fill=\"none\" stroke-width=\"");
+    out.putInt(SceneRenderer::PenWidth);
+    out.put("\" stroke-linecap=\"square\" stroke-linejoin=\"bevel\">\n");
+
+    QVector<QPoint> stroke;
+    for (const SnapshotLayer& layer : snapshot.layers) {
+        const ShapeStore& shapes = layer.shapes;
+        if (shapes.isEmpty() || layer.opacity <= 0.0) {
+            done += shapes.size();
+            continue;
+        }
+        const bool translucent = layer.opacity < 1.0;
+        if (translucent) {
+            out.put("<g opacity=\"");
+            out.put(QByteArray::number(layer.opacity, 'g', 3));
+            out.put("\">\n");
+        }
+        int first = 0;
+        while (first < shapes.size()) {
+            const int end = runEnd(shapes, first);
+            const QColor& color = shapes.colorAt(first);
+            out.put("<g stroke=\"");
+            out.put(color.name().toLatin1());
+            if (color.alpha() < 255) {
+                out.put("\" stroke-opacity=\"");
+                out.put(QByteArray::number(color.alphaF(), 'g', 3));
+            }
+            out.put("\">\n");
+            for (int index = first; index < end; ++index) {
+                writeShape(out, shapes, index, stroke);
+                if (progress && ++done % ProgressStep == 0) {
+                    progress(done, total);
+                }
+            }
+            out.put("</g>\n");
+            first = end;
+        }
+        if (translucent) {
+            out.put("</g>\n");
+        }
+    }
+    out.put("</g>\n</svg>\n");
+
+    if (progress) {
+        progress(total, total);
+    }
+    return out.flush() && file.commit();
+}
+
+// 1 ضӦ 1ptҳСڻС
+bool VectorExporter::savePdf(const SceneSnapshot& snapshot, const QString& filePath,
+    const std::function<void(int done, int total)>& progress) {
+    PROFILE_SCOPE("VectorExporter::savePdf");
+    if (snapshot.size.isEmpty()) {
+        return false;
+    }
+    QPdfWriter writer(filePath);
+    writer.setCreator("VectorGraphicsRenderingSystem");
+    writer.setResolution(72);
+    writer.setPageSize(QPageSize(QSizeF(snapshot.size), QPageSize::Point, QString(), QPageSize::ExactMatch));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        return false;
+    }
+    painter.fillRect(QRect(QPoint(0, 0), snapshot.size), Qt::white);
+
+    const int total = shapeCount(snapshot);
+    int done = 0;
+    QVector<QPoint> stroke;
+    QVector<QLine> lines;
+    lines.reserve(LineChunk);
+    for (const SnapshotLayer& layer : snapshot.layers) {
+        const ShapeStore& shapes = layer.shapes;
+        if (shapes.isEmpty() || layer.opacity <= 0.0) {
+            done += shapes.size();
+            continue;
+        }
+        //͸ֱڻϣʸͬһͼ໥ǵͼλ͸
+        painter.setOpacity(layer.opacity);
+        int first = 0;
+        while (first < shapes.size()) {
+            const int end = runEnd(shapes, first);
+            painter.setPen(QPen(shapes.colorAt(first), SceneRenderer::PenWidth));
+            for (int index = first; index < end; ++index) {
+                SceneRenderer::drawShape(painter, shapes, index, nullptr, 1.0, lines, stroke);
+                if (lines.size() == LineChunk) {
+                    painter.drawLines(lines.constData(), lines.size());
+                    lines.clear();
+                }
+                if (progress && ++done % ProgressStep == 0) {
+                    progress(done, total);
+                }
+            }
+            if (!lines.isEmpty()) {
+                painter.drawLines(lines.constData(), lines.size());
+                lines.clear();
+            }
+            first = end;
+        }
+    }
+
+    if (progress) {
+        progress(total, total);
+    }
+    return painter.end();
+}
@@ -0,0 +1,22 @@
+#ifndef VECTOREXPORTER_H
+#define VECTOREXPORTER_H
+
+#include <QString>
+#include <functional>
+#include "SceneRenderer.h"
+
+//ʸֱӴӿյͼβֿдͼΣդ DOM
+//ͼΰ±˳д뻭ĵ˳һ£±ڵͬɫͼιһ stroke һλ
+//SVG ̶СĻ˳дֻ̣ linepolylineellipse  gɱ SvgImporter أ
+//PDF  QPdfWriter Ϊ 1pt ҳ
+//ͼƬ
+class VectorExporter {
+public:
+    //progress ڵ߳бãΪдܵͼ
+    static bool saveSvg(const SceneSnapshot& snapshot, const QString& filePath,
+        const std::function<void(int done, int total)>& progress = nullptr);
+    static bool savePdf(const SceneSnapshot& snapshot, const QString& filePath,
+        const std::function<void(int done, int total)>& progress = nullptr);
+};
+
+#endif // VECTOREXPORTER_H
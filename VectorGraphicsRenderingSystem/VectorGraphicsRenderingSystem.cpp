@@ -1,14 +1,20 @@
 #include "VectorGraphicsRenderingSystem.h"
 #include "ui_VectorGraphicsRenderingSystem.h"
 #include "Layer.h"
+#include "SceneFile.h"
+#include "Profiler.h"
 #include <QFileDialog>
 #include <QImage>
 #include <QPixmap>
 #include <QMessageBox>
 #include <QLabel>
+#include <QInputDialog>
+#include <QFileInfo>
+#include <QDockWidget>
+#include <QScreen>
 
 VectorGraphicsRenderingSystem::VectorGraphicsRenderingSystem(QWidget* parent)
-    : QMainWindow(parent), layer(nullptr) {
+    : QMainWindow(parent), layer(nullptr), layerPanel(nullptr) {
     ui.setupUi(this);
 
     setWindowIcon(QIcon(":/VectorGraphicsRenderingSystem/res/draw.png"));
@@ -26,6 +32,12 @@ VectorGraphicsRenderingSystem::VectorGraphicsRenderingSystem(QWidget* parent)
 
     setCentralWidget(ui.scrollArea);
 
+    //ͼͣҲ
+    layerPanel = new LayerPanel(this);
+    QDockWidget* layerDock = new QDockWidget("Layers", this);
+    layerDock->setWidget(layerPanel);
+    addDockWidget(Qt::RightDockWidgetArea, layerDock);
+
     connect(ui.createFile, &QAction::triggered, this, &VectorGraphicsRenderingSystem::createLayer);
     connect(ui.openFile, &QAction::triggered, this, &VectorGraphicsRenderingSystem::openFile);
     connect(ui.saveFile, &QAction::triggered, this, &VectorGraphicsRenderingSystem::saveFile);
@@ -33,20 +45,73 @@ VectorGraphicsRenderingSystem::VectorGraphicsRenderingSystem(QWidget* parent)
     connect(ui.line, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setLineMode);
     connect(ui.polyline, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setPolylineMode);
     connect(ui.ellipse, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setEllipseMode);
+    connect(ui.freehand, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setFreehandMode);
 
     connect(ui.choose, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setSelectMode);
     connect(ui.move, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setMoveMode);
     connect(ui.changeColor, &QAction::triggered, this, &VectorGraphicsRenderingSystem::setChangeColorMode);
+    connect(ui.undo, &QAction::triggered, this, &VectorGraphicsRenderingSystem::undo);
+    connect(ui.redo, &QAction::triggered, this, &VectorGraphicsRenderingSystem::redo);
+
+    connect(ui.showOverlay, &QAction::toggled, this, &VectorGraphicsRenderingSystem::setOverlayVisible);
+    connect(ui.recordTrace, &QAction::toggled, this, &VectorGraphicsRenderingSystem::setTraceRecording);
+    connect(ui.exportTrace, &QAction::triggered, this, &VectorGraphicsRenderingSystem::exportTrace);
 
     connect(ui.Tips, & QAction::triggered, this, &VectorGraphicsRenderingSystem::showTips);
+
+    //ͼƬʱʾæµȡť
+    loadProgress = new QProgressBar(this);
+    loadProgress->setRange(0, 0);
+    loadProgress->setMaximumWidth(160);
+    loadCancel = new QToolButton(this);
+    loadCancel->setText("Cancel");
+    ui.statusBar->addPermanentWidget(loadProgress);
+    ui.statusBar->addPermanentWidget(loadCancel);
+    setLoading(false);
+    connect(loadCancel, &QToolButton::clicked, this, [this]() {
+        cancelLoad(false);
+        ui.statusBar->showMessage("Image loading canceled");
+    });
+
+    //̨Ľ
+    exportQueue = new ExportQueue(this);
+    exportProgress = new QProgressBar(this);
+    exportProgress->setRange(0, 100);
+    exportProgress->setMaximumWidth(160);
+    exportProgress->setVisible(false);
+    ui.statusBar->addPermanentWidget(exportProgress);
+    connect(exportQueue, &ExportQueue::progress, this, [this](const QString& filePath, int percent) {
+        exportProgress->setVisible(true);
+        exportProgress->setValue(percent);
+        exportProgress->setFormat(QString("%1 %p%").arg(QFileInfo(filePath).fileName()));
+        const int waiting = exportQueue->pending() - 1;
+        exportProgress->setToolTip(waiting > 0 ? QString("%1 more exports queued").arg(waiting) : QString());
+    });
+    connect(exportQueue, &ExportQueue::finished, this, [this](const QString& filePath, bool ok, qint64 elapsedMs) {
+        exportProgress->setVisible(exportQueue->pending() > 0);
+        if (!ok) {
+            QMessageBox::critical(this, "Error", QString("Failed to save image %1.").arg(filePath));
+            return;
+        }
+        ui.statusBar->showMessage(QString("Exported %1 in %2 ms").arg(QFileInfo(filePath).fileName()).arg(elapsedMs));
+    });
 }
 
 VectorGraphicsRenderingSystem::~VectorGraphicsRenderingSystem() {
+    cancelImport();
+    cancelLoad(true);
+    //ȡڽļ߳ҲҪ
+    for (QThread* thread : findChildren<QThread*>()) {
+        thread->quit();
+        thread->wait();
+    }
     delete layer;
 }
 
 //½ͼ
 void VectorGraphicsRenderingSystem::createLayer() {
+    cancelImport();
+    cancelLoad(false);
     if (layer) {
         delete layer;
         layer = nullptr;
@@ -62,29 +127,186 @@ void VectorGraphicsRenderingSystem::createLayer() {
 
         layer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     }
+    layer->setOverlayVisible(ui.showOverlay->isChecked());
+    layerPanel->setCanvas(layer);
 }
 
 //ļ
 void VectorGraphicsRenderingSystem::openFile() {
-    QString filePath = QFileDialog::getOpenFileName(this, "Open Image File", "", "Images (*.png *.jpg)");
+    QString filePath = QFileDialog::getOpenFileName(this, "Open File", "", "Images (*.png *.jpg);;Vector Scene (*.vgs);;SVG (*.svg)");
 
     if (filePath.isEmpty()) {
         return;
     }
+    PROFILE_SCOPE("VectorGraphicsRenderingSystem::openFile");
+    cancelLoad(false);
+
+    //SVG ں̨߳ʽ룬ʾ
+    if (filePath.endsWith(".svg")) {
+        importSvg(filePath);
+        return;
+    }
 
-    QImage image(filePath);
-    if (image.isNull()) {
-        QMessageBox::critical(this, "Error", "Failed to load image.");
+    //ʸֱͼβֿ
+    if (filePath.endsWith(".vgs")) {
+        cancelImport();
+        ShapeStore shapes;
+        QSize size;
+        if (!SceneFile::load(filePath, shapes, size)) {
+            QMessageBox::critical(this, "Error", "Failed to load scene.");
+            return;
+        }
+        if (!layer) {
+            createLayer();
+        }
+        layer->clear();
+        layer->setShapes(shapes);
+        //ΪʱĴСʱɹΧ뱣ǰһ£С⻺ͼ
+        layer->setMinimumSize(size.boundedTo(screen()->availableVirtualSize()));
         return;
     }
 
+    loadImage(filePath);
+}
+
+//ڹ߳нͼƬʾԤɺ滻Ϊķֿ鱳ڼԼ
+void VectorGraphicsRenderingSystem::loadImage(const QString& filePath) {
+    cancelImport();
+    cancelLoad(false);
     if (!layer) {
         createLayer();
     }
+    layer->clear();
+    layer->setMinimumSize(0, 0);
+    layer->setBackground(QSharedPointer<TiledImage>());
+
+    QThread* thread = new QThread(this);
+    ImageLoader* worker = new ImageLoader(filePath);
+    worker->moveToThread(thread);
+    loadThread = thread;
+    loader = worker;
+
+    connect(thread, &QThread::started, worker, &ImageLoader::run);
+    //ȡļԿʹֻյǰصĽ
+    QPointer<ImageLoader> guard(worker);
+    connect(worker, &ImageLoader::previewReady, this, [this, guard](const QImage& preview, const QSize& size) {
+        if (!guard || guard != loader || !layer) {
+            return;
+        }
+        layer->setPreview(preview, size);
+        ui.statusBar->showMessage("Showing preview, decoding full resolution...");
+    });
+    QPointer<QThread> threadGuard(thread);
+    connect(worker, &ImageLoader::finished, this, [this, guard, threadGuard](bool ok, const QSharedPointer<TiledImage>& image, qint64 elapsedMs, const QString& error) {
+        if (threadGuard) {
+            threadGuard->quit();
+        }
+        if (!guard || guard != loader) {
+            return;
+        }
+        setLoading(false);
+        if (!ok) {
+            if (layer) {
+                layer->setPreview(QImage(), QSize());
+            }
+            QMessageBox::critical(this, "Error", QString("Failed to load image. %1").arg(error));
+            return;
+        }
+        if (layer) {
+            layer->setBackground(image);
+        }
+        ui.statusBar->showMessage(QString("Loaded %1 x %2 image in %3 ms")
+            .arg(image->size().width()).arg(image->size().height()).arg(elapsedMs));
+    });
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+    setLoading(true);
+    ui.statusBar->showMessage("Loading image...");
+    thread->start();
+}
+
+//ȡڽеļأִеĽ޷жϣwait Ϊʱȴ󱻶
+void VectorGraphicsRenderingSystem::cancelLoad(bool wait) {
+    if (loader) {
+        loader->cancel();
+        loader = nullptr;
+    }
+    if (loadThread) {
+        loadThread->quit();
+        if (wait) {
+            loadThread->wait();
+        }
+        loadThread = nullptr;
+    }
+    setLoading(false);
+}
+
+void VectorGraphicsRenderingSystem::setLoading(bool loading) {
+    loadProgress->setVisible(loading);
+    loadCancel->setVisible(loading);
+}
 
+//SVG
+void VectorGraphicsRenderingSystem::importSvg(const QString& filePath) {
+    cancelImport();
+    if (!layer) {
+        createLayer();
+    }
     layer->clear();
 
-    layer->setImage(image);
+    QThread* thread = new QThread(this);
+    SvgImporter* worker = new SvgImporter(filePath);
+    worker->moveToThread(thread);
+    importThread = thread;
+    importer = worker;
+
+    connect(thread, &QThread::started, worker, &SvgImporter::run);
+    //ȡĵܻ¼Уֻյǰ
+    QPointer<SvgImporter> guard(worker);
+    connect(worker, &SvgImporter::batchReady, this, [this, guard](const ShapeStore& batch) {
+        if (!guard || guard != importer) {
+            return;
+        }
+        if (layer) {
+            layer->appendShapes(batch);
+        }
+        guard->releaseBatch();
+    });
+    QPointer<QThread> threadGuard(thread);
+    connect(worker, &SvgImporter::finished, this, [this, guard, threadGuard](bool ok, int shapeCount, qint64 elapsedMs, const QString& error) {
+        if (threadGuard) {
+            threadGuard->quit();
+        }
+        if (!guard || guard != importer) {
+            return;
+        }
+        if (ok) {
+            const qreal rate = elapsedMs > 0 ? shapeCount * 1000.0 / elapsedMs : shapeCount;
+            ui.statusBar->showMessage(QString("Imported %1 shapes in %2 ms (%3 shapes/s)")
+                .arg(shapeCount).arg(elapsedMs).arg(qRound64(rate)));
+        }
+        else {
+            ui.statusBar->showMessage(QString("SVG import failed: %1").arg(error));
+        }
+    });
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+    thread->start();
+}
+
+//ȡڽеĵ벢ȴ߳˳¼еǵǰ
+void VectorGraphicsRenderingSystem::cancelImport() {
+    if (importer) {
+        importer->cancel();
+        importer = nullptr;
+    }
+    if (importThread) {
+        importThread->quit();
+        importThread->wait();
+        importThread = nullptr;
+    }
 }
 
 //ļ
@@ -94,23 +316,45 @@ void VectorGraphicsRenderingSystem::saveFile() {
         return;
     }
 
-    QString filePath = QFileDialog::getSaveFileName(this, "Save Image File", "", "Images (*.png *.jpg)");
+    QString filePath = QFileDialog::getSaveFileName(this, "Save File", "", "Images (*.png *.jpg);;Vector Scene (*.vgs);;SVG (*.svg);;PDF (*.pdf)");
     if (filePath.isEmpty()) {
         return;
     }
 
-    if (!filePath.endsWith(".png") && !filePath.endsWith(".jpg")) {
-        filePath.append(".png");
+    //ʸ˳дȫͼ
+    if (filePath.endsWith(".vgs")) {
+        //ļֻһͼ㣺ɼͼ¶Ϻϲ󱣴棬صͼ㡢ͼ벻͸Ȳ棬ǰʾ
+        const bool flattened = layer->layerCount() > 1 || !layer->isLayerVisible(0) || layer->layerOpacity(0) < 1.0;
+        if (flattened && QMessageBox::question(this, "Save Scene",
+            "Scene files (.vgs) store a single layer. Visible layers will be merged into one; "
+            "hidden layers, layer names and opacity will not be saved. Continue?") != QMessageBox::Yes) {
+            return;
+        }
+        PROFILE_SCOPE("VectorGraphicsRenderingSystem::saveFile");
+        if (!SceneFile::save(filePath, layer->mergedShapes(), layer->size())) {
+            QMessageBox::critical(this, "Error", "Failed to save scene.");
+        }
+        return;
     }
 
-    QPixmap pixmap(layer->size());
-    layer->render(&pixmap);
-
-    QImage image = pixmap.toImage();
-
-    if (!image.save(filePath)) {
-        QMessageBox::critical(this, "Error", "Failed to save image.");
+    //SVG  PDF ʸֱ޹أѯʵ
+    double scale = 1.0;
+    if (!filePath.endsWith(".svg") && !filePath.endsWith(".pdf")) {
+        if (!filePath.endsWith(".png") && !filePath.endsWith(".jpg")) {
+            filePath.append(".png");
+        }
+
+        //ڴڳߴͼ
+        bool ok = false;
+        scale = QInputDialog::getDouble(this, "Export Scale", "Scale factor:", 1.0, 0.1, 64.0, 2, &ok);
+        if (!ok) {
+            return;
+        }
     }
+
+    //뻭ݣ֮ı༭Ӱ쵼Ⱦڵ߳н
+    PROFILE_SCOPE("VectorGraphicsRenderingSystem::saveFile");
+    exportQueue->enqueue(layer->snapshot(), scale, filePath);
 }
 
 //תģʽ
@@ -135,6 +379,13 @@ void VectorGraphicsRenderingSystem::setEllipseMode() {
     }
 }
 
+//ֻ
+void VectorGraphicsRenderingSystem::setFreehandMode() {
+    if (layer) {
+        layer->setDrawMode(Layer::Freehand);
+    }
+}
+
 //ѡ
 void VectorGraphicsRenderingSystem::setSelectMode() {
     if (layer) {
@@ -156,6 +407,54 @@ void VectorGraphicsRenderingSystem::setChangeColorMode() {
     }
 }
 
+//
+void VectorGraphicsRenderingSystem::undo() {
+    if (layer) {
+        layer->undo();
+    }
+}
+
+//
+void VectorGraphicsRenderingSystem::redo() {
+    if (layer) {
+        layer->redo();
+    }
+}
+
+//ܸ
+void VectorGraphicsRenderingSystem::setOverlayVisible(bool visible) {
+    if (layer) {
+        layer->setOverlayVisible(visible);
+    }
+}
+
+//ʼֹͣ¼ʱ¼ʼʱһεļ¼
+void VectorGraphicsRenderingSystem::setTraceRecording(bool recording) {
+    Profiler::setEnabled(recording);
+    ui.statusBar->showMessage(recording ? QString("Recording trace...")
+        : QString("Trace stopped, %1 events recorded").arg(Profiler::eventCount()));
+}
+
+//Ϊ Chrome trace-event JSON chrome://tracing  Perfetto в鿴
+void VectorGraphicsRenderingSystem::exportTrace() {
+    if (Profiler::eventCount() == 0) {
+        QMessageBox::information(this, "Export Trace", "No trace events recorded. Enable trace recording first.");
+        return;
+    }
+    QString filePath = QFileDialog::getSaveFileName(this, "Export Trace", "", "Chrome Trace (*.json)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+    if (!filePath.endsWith(".json")) {
+        filePath.append(".json");
+    }
+    if (!Profiler::exportChromeTrace(filePath)) {
+        QMessageBox::critical(this, "Error", "Failed to export trace.");
+        return;
+    }
+    ui.statusBar->showMessage(QString("Exported %1 trace events").arg(Profiler::eventCount()));
+}
+
 //תʾҳ
 void VectorGraphicsRenderingSystem::showTips() {
     Tips* tips = new Tips();
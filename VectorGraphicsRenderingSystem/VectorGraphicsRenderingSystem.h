@@ -4,6 +4,14 @@
 #include "ui_VectorGraphicsRenderingSystem.h"
 #include "Layer.h"
 #include "Tips.h"
+#include "SvgImporter.h"
+#include "ImageLoader.h"
+#include "ExportQueue.h"
+#include "LayerPanel.h"
+#include <QPointer>
+#include <QThread>
+#include <QProgressBar>
+#include <QToolButton>
 
 
 class VectorGraphicsRenderingSystem : public QMainWindow
@@ -21,12 +29,36 @@ public slots:
     void setLineMode();
     void setPolylineMode();
     void setEllipseMode();
+    void setFreehandMode();
     void setSelectMode();
     void setMoveMode();
     void setChangeColorMode();
+    void undo();
+    void redo();
+    void setOverlayVisible(bool visible);
+    void setTraceRecording(bool recording);
+    void exportTrace();
     void showTips();
 
 private:
     Ui::VectorGraphicsRenderingSystemClass ui;
     Layer* layer;
+    LayerPanel* layerPanel;
+
+    void importSvg(const QString& filePath);
+    void cancelImport();
+    QPointer<QThread> importThread;
+    QPointer<SvgImporter> importer;
+
+    //̨ͼƬ״̬ʾȡť
+    void loadImage(const QString& filePath);
+    void cancelLoad(bool wait);
+    void setLoading(bool loading);
+    QPointer<QThread> loadThread;
+    QPointer<ImageLoader> loader;
+    QProgressBar* loadProgress;
+    QToolButton* loadCancel;
+
+    ExportQueue* exportQueue;
+    QProgressBar* exportProgress;
 };
@@ -0,0 +1,344 @@
+//ܻ׼ơвԡ㡢ں뵼Ϊ JSONڿ汾Ա
+//÷vgrs_bench [--output results.json] [--sizes 1000,100000,1000000]
+#include "../Layer.h"
+#include "../GeometryKernels.h"
+#include "../SceneExporter.h"
+#include "../PngEncoder.h"
+#include "../VectorExporter.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QLineF>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+static const int Extent = 2048;
+static const int Probes = 2000;
+
+static QJsonArray results;
+
+static void record(const QString& name, int shapes, double value, const QString& unit) {
+    QJsonObject entry;
+    entry["benchmark"] = name;
+    entry["shapes"] = shapes;
+    entry["value"] = value;
+    entry["unit"] = unit;
+    results.append(entry);
+    QTextStream(stderr) << name << '\t' << shapes << '\t' << value << ' ' << unit << '\n';
+}
+
+static double elapsedMs(const std::function<void()>& work) {
+    QElapsedTimer timer;
+    timer.start();
+    work();
+    return timer.nsecsElapsed() / 1.0e6;
+}
+
+// Extent x Extent Ļ count ߡߡԲ
+static void populate(Layer& layer, int count, QRandomGenerator& rng) {
+    const QColor colors[] = { Qt::black, Qt::red, Qt::blue, Qt::darkGreen };
+    QVector<QPoint> points;
+    for (int i = 0; i < count; ++i) {
+        const QPoint origin(rng.bounded(Extent), rng.bounded(Extent));
+        const QColor& color = colors[rng.bounded(4)];
+        switch (i % 3) {
+        case 0:
+            layer.addLine(QLine(origin, origin + QPoint(rng.bounded(-60, 60), rng.bounded(-60, 60))), color);
+            break;
+        case 1: {
+            points.clear();
+            const int n = 3 + rng.bounded(6);
+            for (int j = 0; j < n; ++j) {
+                points.append(origin + QPoint(rng.bounded(80), rng.bounded(80)));
+            }
+            layer.addPolyline(points, color);
+            break;
+        }
+        default:
+            layer.addEllipse(QRect(origin, QSize(1 + rng.bounded(80), 1 + rng.bounded(80))), color);
+            break;
+        }
+    }
+}
+
+static void benchPaint(Layer& layer, int count) {
+    QImage target(layer.size(), QImage::Format_ARGB32_Premultiplied);
+
+    //ȥʹȫʧЧʱؽ
+    layer.setBackground(QSharedPointer<TiledImage>());
+    layer.resetView();
+    record("paint_cold", count, elapsedMs([&]() { layer.render(&target); }), "ms");
+    //Уֻ
+    record("paint_cached", count, elapsedMs([&]() { layer.render(&target); }), "ms");
+}
+
+static void benchHitTest(Layer& layer, int count, QRandomGenerator& rng) {
+    QVector<QPoint> probes;
+    for (int i = 0; i < Probes; ++i) {
+        probes.append(QPoint(rng.bounded(Extent), rng.bounded(Extent)));
+    }
+
+    double ms = elapsedMs([&]() {
+        for (const QPoint& p : probes) {
+            layer.hitTest(p, 5.0);
+        }
+    });
+    record("hit_select", count, ms * 1000.0 / Probes, "us/op");
+
+    ms = elapsedMs([&]() {
+        for (const QPoint& p : probes) {
+            int id = layer.hitTest(p, 5.0);
+            if (id >= 0) {
+                layer.moveShape(id, QPoint(1, 1));
+            }
+        }
+    });
+    record("hit_move", count, ms * 1000.0 / Probes, "us/op");
+
+    ms = elapsedMs([&]() {
+        for (const QPoint& p : probes) {
+            int id = layer.hitTest(p, 5.0);
+            if (id >= 0) {
+                layer.setShapeColor(id, Qt::magenta);
+            }
+        }
+    });
+    record("hit_recolor", count, ms * 1000.0 / Probes, "us/op");
+}
+
+static void benchMetrics(const Layer& layer, int count) {
+    const ShapeStore& shapes = layer.shapeStore();
+    volatile qreal sink = 0.0;
+
+    int polylines = 0;
+    double ms = elapsedMs([&]() {
+        qreal total = 0.0;
+        for (int i = 0; i < shapes.size(); ++i) {
+            if (shapes.typeAt(i) == ShapeStore::PolylineType) {
+                total += layer.calculatePolylineLength(shapes.pointsAt(i), shapes.pointCountAt(i));
+                ++polylines;
+            }
+        }
+        sink = total;
+    });
+    record("polyline_length", count, ms > 0.0 ? polylines / ms * 1000.0 : 0.0, "shapes/s");
+
+    int ellipses = 0;
+    ms = elapsedMs([&]() {
+        qreal total = 0.0;
+        for (int i = 0; i < shapes.size(); ++i) {
+            if (shapes.typeAt(i) == ShapeStore::EllipseType) {
+                total += layer.calculateEllipseArea(shapes.ellipseAt(i));
+                ++ellipses;
+            }
+        }
+        sink = total;
+    });
+    record("ellipse_area", count, ms > 0.0 ? ellipses / ms * 1000.0 : 0.0, "shapes/s");
+    Q_UNUSED(sink);
+}
+
+//ͼжϵĲοʵ֣ں֮ǰв߼
+static bool referenceNearLine(const QPoint& point, const QLine& line, qreal tolerance) {
+    QLineF lineF(line);
+    if (QLineF(lineF.p1(), point).length() < tolerance || QLineF(lineF.p2(), point).length() < tolerance) {
+        return true;
+    }
+    qreal numerator = std::abs((lineF.dy() * point.x()) - (lineF.dx() * point.y()) + (lineF.p2().x() * lineF.p1().y()) - (lineF.p2().y() * lineF.p1().x()));
+    qreal distance = numerator / lineF.length();
+    return (distance <= tolerance && point.x() >= std::min(lineF.p1().x(), lineF.p2().x()) &&
+        point.x() <= std::max(lineF.p1().x(), lineF.p2().x()) &&
+        point.y() >= std::min(lineF.p1().y(), lineF.p2().y()) &&
+        point.y() <= std::max(lineF.p1().y(), lineF.p2().y()));
+}
+
+static bool referenceInEllipse(const QPoint& point, const QRect& box, qreal margin) {
+    const QRectF r(box);
+    const qreal nx = (point.x() - r.center().x()) / (r.width() / 2 + margin);
+    const qreal ny = (point.y() - r.center().y()) / (r.height() / 2 + margin);
+    return nx * nx + ny * ny <= 1.0;
+}
+
+//ںͼεĺԱȣںÿõָϸһ
+static void benchKernels(const Layer& layer, int count) {
+    const ShapeStore& shapes = layer.shapeStore();
+    const QPoint probe(Extent / 2, Extent / 2);
+    SegmentBatch lines;
+    EllipseBatch ellipses;
+    QVector<int> polylineOffsets, polylineCounts;
+    for (int i = 0; i < shapes.size(); ++i) {
+        switch (shapes.typeAt(i)) {
+        case ShapeStore::LineType:
+            lines.append(i, shapes.pointsAt(i)[0], shapes.pointsAt(i)[1], probe);
+            break;
+        case ShapeStore::PolylineType:
+            polylineOffsets.append(int(shapes.pointsAt(i) - shapes.pointColumn()));
+            polylineCounts.append(shapes.pointCountAt(i));
+            break;
+        case ShapeStore::EllipseType:
+            ellipses.append(i, shapes.boundsAt(i), probe);
+            break;
+        default:
+            break;
+        }
+    }
+    auto rate = [](int n, double ms) { return ms > 0.0 ? n / ms * 1000.0 : 0.0; };
+    volatile int hits = 0;
+
+    double ms = elapsedMs([&]() {
+        int found = 0;
+        for (int i = 0; i < shapes.size(); ++i) {
+            if (shapes.typeAt(i) == ShapeStore::LineType && referenceNearLine(probe, shapes.lineAt(i), 5.0)) {
+                ++found;
+            }
+        }
+        hits = found;
+    });
+    record("segment_distance_per_shape", count, rate(lines.size(), ms), "shapes/s");
+
+    ms = elapsedMs([&]() {
+        int found = 0;
+        for (int i = 0; i < shapes.size(); ++i) {
+            if (shapes.typeAt(i) == ShapeStore::EllipseType && referenceInEllipse(probe, shapes.boundsAt(i), 5.0)) {
+                ++found;
+            }
+        }
+        hits = found;
+    });
+    record("ellipse_contains_per_shape", count, rate(ellipses.size(), ms), "shapes/s");
+
+    QVector<qreal> lengths(polylineCounts.size());
+    lines.distances.resize(lines.size());
+    ellipses.inside.resize(ellipses.size());
+    for (int level = GeometryKernels::Scalar; level <= GeometryKernels::detectedIsa(); ++level) {
+        GeometryKernels::limitIsa(GeometryKernels::Isa(level));
+        const QString suffix = QString("_") + GeometryKernels::isaName(GeometryKernels::Isa(level));
+
+        ms = elapsedMs([&]() {
+            GeometryKernels::segmentDistancesSquared(lines.x0.constData(), lines.y0.constData(), lines.x1.constData(),
+                lines.y1.constData(), lines.size(), 0.0f, 0.0f, lines.distances.data());
+        });
+        record("segment_distance" + suffix, count, rate(lines.size(), ms), "shapes/s");
+
+        ms = elapsedMs([&]() {
+            GeometryKernels::ellipsesContain(ellipses.cx.constData(), ellipses.cy.constData(), ellipses.rx.constData(),
+                ellipses.ry.constData(), ellipses.size(), 0.0f, 0.0f, 5.0f, ellipses.inside.data());
+        });
+        record("ellipse_contains" + suffix, count, rate(ellipses.size(), ms), "shapes/s");
+
+        ms = elapsedMs([&]() {
+            GeometryKernels::polylineLengths(shapes.pointColumn(), polylineOffsets.constData(), polylineCounts.constData(),
+                polylineCounts.size(), lengths.data());
+        });
+        record("polyline_length" + suffix, count, rate(polylineCounts.size(), ms), "shapes/s");
+    }
+    GeometryKernels::limitIsa(GeometryKernels::Avx2);
+    Q_UNUSED(hits);
+}
+
+//ɾ 1% ͼβѹֿ⣬ٰԭλ÷Żأɾ·
+static void benchDelete(const Layer& layer, int count) {
+    ShapeStore shapes = layer.shapeStore();
+    QVector<int> indices;
+    QVector<int> ids;
+    for (int i = 0; i < shapes.size(); i += 100) {
+        indices.append(i);
+        ids.append(shapes.idAt(i));
+    }
+    const ShapeStore removed = shapes.extract(indices);
+    record("delete_compact", count, elapsedMs([&]() { shapes.remove(indices); }), "ms");
+    record("delete_reinsert", count, elapsedMs([&]() { shapes.reinsert(removed, ids, indices); }), "ms");
+}
+
+// saveFile ͬ·աֿȾPNG д̣¼ QImageWriter ̱߳
+static void benchExport(const Layer& layer, int count, const QString& directory) {
+    const qreal scales[] = { 1.0, 4.0 };
+    for (qreal scale : scales) {
+        SceneExporter exporter;
+        QImage image;
+        const QString suffix = QString("_x%1").arg(scale);
+        record("export_render" + suffix, count, elapsedMs([&]() { image = exporter.render(layer.snapshot(), scale); }), "ms");
+        const QString filePath = directory + QString("/export_%1%2.png").arg(count).arg(suffix);
+        record("export_encode" + suffix, count, elapsedMs([&]() { PngEncoder::save(image, filePath); }), "ms");
+        record("export_encode_qt" + suffix, count, elapsedMs([&]() { image.save(filePath); }), "ms");
+    }
+
+    //ʸͼд̣դ
+    const SceneSnapshot snapshot = layer.snapshot();
+    const QString svgPath = directory + QString("/export_%1.svg").arg(count);
+    record("export_svg", count, elapsedMs([&]() { VectorExporter::saveSvg(snapshot, svgPath); }), "ms");
+    record("export_svg_size", count, QFileInfo(svgPath).size() / 1024.0, "KiB");
+    const QString pdfPath = directory + QString("/export_%1.pdf").arg(count);
+    record("export_pdf", count, elapsedMs([&]() { VectorExporter::savePdf(snapshot, pdfPath); }), "ms");
+}
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("VectorGraphicsRenderingSystem benchmarks");
+    parser.addHelpOption();
+    QCommandLineOption outputOption("output", "Write JSON results to this file.", "file");
+    QCommandLineOption sizesOption("sizes", "Comma-separated shape counts.", "list", "1000,100000,1000000");
+    parser.addOption(outputOption);
+    parser.addOption(sizesOption);
+    parser.process(app);
+
+    QVector<int> sizes;
+    for (const QString& size : parser.value(sizesOption).split(',')) {
+        bool ok = false;
+        int count = size.trimmed().toInt(&ok);
+        if (ok && count > 0) {
+            sizes.append(count);
+        }
+    }
+
+    QTemporaryDir exportDir;
+    for (int count : sizes) {
+        QRandomGenerator rng(42);
+        std::unique_ptr<Layer> layer(new Layer());
+        layer->resize(Extent, Extent);
+        populate(*layer, count, rng);
+
+        benchPaint(*layer, count);
+        benchMetrics(*layer, count);
+        benchKernels(*layer, count);
+        benchExport(*layer, count, exportDir.path());
+        benchDelete(*layer, count);
+        benchHitTest(*layer, count, rng);
+    }
+
+    QJsonObject report;
+    report["suite"] = "vgrs_bench";
+    report["qt"] = QString(qVersion());
+    report["isa"] = QString(GeometryKernels::isaName(GeometryKernels::detectedIsa()));
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            QTextStream(stderr) << "Cannot write " << file.fileName() << '\n';
+            return 1;
+        }
+    }
+    else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -1,8 +1,19 @@
 #include "VectorGraphicsRenderingSystem.h"
+#include "BatchRenderer.h"
 #include <QtWidgets/QApplication>
+#include <QtGui/QGuiApplication>
 
 int main(int argc, char *argv[])
 {
+    //޽Ⱦֻ QGuiApplicationĬʹ offscreen ƽ̨
+    if (BatchRenderer::isRequested(argc, argv)) {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        QGuiApplication app(argc, argv);
+        return BatchRenderer::run(app.arguments());
+    }
+
     QApplication a(argc, argv);
     VectorGraphicsRenderingSystem w;
     w.show();